@@ -0,0 +1,229 @@
+#ifndef AOC22_DAY10_CPU_HPP
+#define AOC22_DAY10_CPU_HPP
+
+#include <string>
+#include <istream>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <charconv>
+#include <concepts>
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <ranges>
+
+enum class OpCode : std::uint8_t {
+    Noop, Addx, Halt
+};
+
+struct Instruction {
+    std::int32_t operand;
+    OpCode op;
+};
+
+/**
+ * Program decoded once into a flat instruction array. Always terminated by a Halt instruction
+ */
+struct Program {
+    static auto decode(std::istream &in) -> Program {
+        Program ret;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.starts_with("noop")) {
+                ret.code.push_back({0, OpCode::Noop});
+            } else if (line.starts_with("addx ")) {
+                Instruction instr{0, OpCode::Addx};
+                const auto *begin = line.data() + 5;
+                if (*begin == '+') {
+                    ++begin;
+                }
+
+                auto [_, ec] = std::from_chars(begin, line.data() + line.size(), instr.operand);
+                if (ec != std::errc{}) {
+                    throw std::runtime_error("invalid operand in line '" + line + "'");
+                }
+
+                ret.code.emplace_back(instr);
+            } else if (not line.empty()) {
+                throw std::runtime_error("unknown instruction '" + line + "'");
+            }
+        }
+
+        ret.code.push_back({0, OpCode::Halt});
+        return ret;
+    }
+
+    std::vector<Instruction> code;
+};
+
+struct CpuState {
+    std::uint64_t cycle;
+    std::int64_t regX;
+};
+
+/**
+ * Placeholder observer. Executing with it skips all per cycle work
+ */
+struct NoObserver {};
+
+/**
+ * Called once per clock cycle with the (1-based) cycle number and the value of register X during that cycle
+ */
+template<typename O>
+concept CycleObserver = std::same_as<std::remove_cvref_t<O>, NoObserver> ||
+                        std::invocable<O &, std::uint64_t, std::int64_t>;
+
+/**
+ * Threaded interpreter for decoded programs. Uses computed goto where available, a switch loop otherwise
+ */
+template<CycleObserver Observer>
+auto execute(const Program &program, Observer &&observer) -> CpuState {
+    constexpr bool Observed = not std::same_as<std::remove_cvref_t<Observer>, NoObserver>;
+    CpuState state{0, 1};
+    auto tick = [&state, &observer]() {
+        ++state.cycle;
+        if constexpr (Observed) {
+            observer(state.cycle, state.regX);
+        }
+    };
+
+    const auto *ip = program.code.data();
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+    static void *const dispatch[] = {&&noop, &&addx, &&halt};
+    goto *dispatch[static_cast<std::size_t>(ip->op)];
+noop:
+    tick();
+    ++ip;
+    goto *dispatch[static_cast<std::size_t>(ip->op)];
+addx:
+    if constexpr (Observed) {
+        tick();
+        tick();
+    } else {
+        state.cycle += 2;
+    }
+
+    state.regX += ip->operand;
+    ++ip;
+    goto *dispatch[static_cast<std::size_t>(ip->op)];
+halt:
+    return state;
+#pragma GCC diagnostic pop
+#else
+    for (;; ++ip) {
+        switch (ip->op) {
+            case OpCode::Noop:
+                tick();
+                break;
+            case OpCode::Addx:
+                tick();
+                tick();
+                state.regX += ip->operand;
+                break;
+            case OpCode::Halt:
+                return state;
+        }
+    }
+#endif
+}
+
+/**
+ * Register X as a piecewise constant function of the clock cycle. Only the retirement of addx instructions changes X,
+ * so the trace stores one entry per addx and answers readouts by binary search (single cycles) or by merging (sorted
+ * batches of cycles). Cost is proportional to instructions + queries instead of cycles
+ */
+class RegisterTrace {
+public:
+    explicit RegisterTrace(const Program &program) {
+        starts.emplace_back(1);
+        values.emplace_back(1);
+        for (const auto &instr : program.code) {
+            switch (instr.op) {
+                case OpCode::Noop:
+                    totalCycles += 1;
+                    break;
+                case OpCode::Addx:
+                    totalCycles += 2;
+                    starts.emplace_back(totalCycles + 1);
+                    values.emplace_back(values.back() + instr.operand);
+                    break;
+                case OpCode::Halt:
+                    break;
+            }
+        }
+    }
+
+    [[nodiscard]] constexpr std::uint64_t numCycles() const noexcept {
+        return totalCycles;
+    }
+
+    /**
+     * Value of X during the given (1-based) cycle
+     */
+    [[nodiscard]] std::int64_t valueDuring(std::uint64_t cycle) const noexcept {
+        auto it = std::ranges::upper_bound(starts, cycle);
+        return values[it - starts.begin() - 1];
+    }
+
+    /**
+     * Calls fun(cycle, X) for each cycle in cycles. Cycles must be sorted, cycles after the end of the program are
+     * ignored
+     */
+    template<std::ranges::input_range R, std::invocable<std::uint64_t, std::int64_t> F>
+    void readAt(R &&cycles, F &&fun) const {
+        std::size_t segment = 0;
+        for (std::uint64_t cycle : cycles) {
+            if (cycle > totalCycles) {
+                break;
+            }
+
+            while (segment + 1 < starts.size() && starts[segment + 1] <= cycle) {
+                ++segment;
+            }
+
+            fun(cycle, values[segment]);
+        }
+    }
+
+    /**
+     * Sum of cycle * X over the given sorted cycles
+     */
+    template<std::ranges::input_range R>
+    [[nodiscard]] std::int64_t signalStrength(R &&cycles) const {
+        std::int64_t ret = 0;
+        readAt(std::forward<R>(cycles), [&ret](std::uint64_t cycle, std::int64_t x) {
+            ret += static_cast<std::int64_t>(cycle) * x;
+        });
+
+        return ret;
+    }
+
+    /**
+     * Calls fun(firstCycle, lastCycle, X) for each maximal range of cycles during which X is constant
+     */
+    template<std::invocable<std::uint64_t, std::uint64_t, std::int64_t> F>
+    void forEachSegment(F &&fun) const {
+        for (std::size_t i = 0; i < starts.size() && starts[i] <= totalCycles; ++i) {
+            auto last = i + 1 < starts.size() ? starts[i + 1] - 1 : totalCycles;
+            fun(starts[i], std::min(last, totalCycles), values[i]);
+        }
+    }
+
+    /**
+     * Readout schedule first, first + period, ... up to the end of the program
+     */
+    [[nodiscard]] auto every(std::uint64_t period, std::uint64_t first) const {
+        return std::views::iota(std::uint64_t(0), first > totalCycles ? 0 : (totalCycles - first) / period + 1) |
+               std::views::transform([period, first](std::uint64_t i) { return first + i * period; });
+    }
+
+private:
+    std::vector<std::uint64_t> starts;
+    std::vector<std::int64_t> values;
+    std::uint64_t totalCycles = 0;
+};
+
+#endif //AOC22_DAY10_CPU_HPP
@@ -0,0 +1,29 @@
+#include <iostream>
+#include <cstdint>
+#include "../util/util.hpp"
+#include "Cpu.hpp"
+
+/**
+ * Runs the interpreter with and without a cycle observer and compares it to the register trace
+ * @return 0 if X matches the trace in every cycle and both runs end in the same state
+ */
+int main(int argc, char **argv) {
+    auto file = util::getInputFile(argc, argv);
+    const auto program = Program::decode(file);
+    const RegisterTrace trace(program);
+    std::uint64_t mismatches = 0;
+    const auto state = execute(program, [&](std::uint64_t cycle, std::int64_t x) {
+        mismatches += x != trace.valueDuring(cycle);
+    });
+
+    const auto unobserved = execute(program, NoObserver{});
+    std::cout << "interpreted " << state.cycle << " cycles, X = " << state.regX << ", " << mismatches
+              << " cycles differ from the trace" << std::endl;
+    const bool consistent = mismatches == 0 && state.cycle == trace.numCycles() && unobserved.cycle == state.cycle &&
+                            unobserved.regX == state.regX;
+    if (not consistent) {
+        std::cerr << "interpreter and register trace differ" << std::endl;
+    }
+
+    return consistent ? 0 : 1;
+}
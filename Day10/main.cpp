@@ -1,82 +1,128 @@
 #include <string>
 #include <iostream>
-#include <optional>
-#include <deque>
-#include <array>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <ranges>
+#include <cassert>
 #include "../util/util.hpp"
+#include "Cpu.hpp"
 
+/**
+ * Monochrome CRT framebuffer with one bit per pixel, rows are padded to full 64 bit words
+ */
+class Framebuffer {
+public:
+    Framebuffer(std::size_t width, std::size_t height) : width(width), height(height), wordsPerRow((width + 63) / 64),
+                                                          pixels(wordsPerRow * height, 0) {}
 
-enum class InstructionType {
-    Noop = 1, Add
-};
+    [[nodiscard]] bool operator()(std::size_t x, std::size_t y) const noexcept {
+        return (pixels[y * wordsPerRow + x / 64] >> (x % 64)) & 1u;
+    }
+
+    /**
+     * Draws the CRT output of a whole program. Pixel i is drawn during cycle i + 1 and is lit if it overlaps with the
+     * three pixel wide sprite centered at X. X is constant over each trace segment, so the lit pixels of a segment are
+     * the intersection of two column ranges per row, set with word masks. Cycles beyond the last pixel are ignored
+     */
+    void render(const RegisterTrace &trace) {
+        const auto numPixels = static_cast<std::uint64_t>(width * height);
+        trace.forEachSegment([this, numPixels](std::uint64_t first, std::uint64_t last, std::int64_t x) {
+            last = std::min(last, numPixels);
+            for (auto cycle = first; cycle <= last;) {
+                const auto row = (cycle - 1) / width;
+                const auto rowEnd = std::min(last, (row + 1) * width);
+                const auto from = std::max(static_cast<std::int64_t>((cycle - 1) % width), x - 1);
+                const auto to = std::min(static_cast<std::int64_t>((rowEnd - 1) % width), x + 1);
+                if (from <= to) {
+                    setRange(row, from, to);
+                }
+
+                cycle = rowEnd + 1;
+            }
+        });
+    }
+
+    [[nodiscard]] auto toText(char lit = '#', char dark = ' ') const -> std::string {
+        std::string ret;
+        ret.reserve((width + 1) * height);
+        for (std::size_t y = 0; y < height; ++y) {
+            for (std::size_t x = 0; x < width; ++x) {
+                ret += (*this)(x, y) ? lit : dark;
+            }
 
-struct Instruction {
-    explicit Instruction(unsigned startingCycle, const std::string &input) {
-        auto parts = util::splitString<' '>(input);
-        if (parts.size() == 1) {
-            type = InstructionType::Noop;
-        } else {
-            type = InstructionType::Add;
-            value = std::stoi(parts.back());
+            ret += '\n';
         }
 
-        finished = startingCycle + execTime();
+        return ret;
     }
 
-    [[nodiscard]] constexpr short execTime() const noexcept {
-        return static_cast<short>(type);
+    /**
+     * Writes the framebuffer as binary portable bitmap (P4)
+     */
+    void writePbm(std::ostream &out) const {
+        const std::size_t bytesPerRow = (width + 7) / 8;
+        std::string data;
+        data.reserve(bytesPerRow * height);
+        for (std::size_t y = 0; y < height; ++y) {
+            for (std::size_t byte = 0; byte < bytesPerRow; ++byte) {
+                auto bits = static_cast<std::uint8_t>(pixels[y * wordsPerRow + byte / 8] >> (8 * (byte % 8)));
+                // pbm stores the leftmost pixel in the most significant bit
+                bits = static_cast<std::uint8_t>((bits * 0x0202020202ull & 0x010884422010ull) % 1023);
+                data += static_cast<char>(bits);
+            }
+        }
+
+        out << "P4\n" << width << " " << height << "\n";
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
     }
 
-    constexpr void exec(int &reg) const noexcept {
-        reg += value.value_or(0);
+private:
+    void setRange(std::size_t row, std::size_t from, std::size_t to) noexcept {
+        auto *line = pixels.data() + row * wordsPerRow;
+        for (auto word = from / 64; word <= to / 64; ++word) {
+            const auto lo = word == from / 64 ? from % 64 : 0;
+            const auto hi = word == to / 64 ? to % 64 : 63;
+            line[word] |= (~std::uint64_t(0) >> (63 - hi)) & (~std::uint64_t(0) << lo);
+        }
     }
 
-    InstructionType type;
-    std::optional<int> value{};
-    unsigned finished;
+    std::size_t width, height, wordsPerRow;
+    std::vector<std::uint64_t> pixels;
 };
 
-
+/**
+ * usage: Day10 [input file] [pbm output file]
+ */
 int main(int argc, char **argv) {
-    auto file = util::getInputFile(argc, argv);
-    std::string line;
-    constexpr std::array readouts{20u, 60u, 100u, 140u, 180u, 220u};
-    auto nextReadout = readouts.begin();
-    unsigned clockCycle = 0;
-    int regX = 1;
-    std::deque<Instruction> instructions;
-    std::getline(file, line);
-    instructions.emplace_back(0, line);
-    unsigned sumSignalStrength = 0;
+    auto file = util::getInputFile(std::min(argc, 2), argv);
+    const auto program = Program::decode(file);
     constexpr unsigned ScreenWidth = 40;
-    while (not instructions.empty()) {
-        if (std::getline(file, line)) {
-            instructions.emplace_back(instructions.back().finished, line);
-        }
-
-        auto crtPos = clockCycle % ScreenWidth;
-        if (std::abs(static_cast<int>(crtPos) - regX) <= 1) {
-            std::cout << "#";
-        } else {
-            std::cout << " ";
+    constexpr std::uint64_t FirstReadout = 20;
+    constexpr std::uint64_t ReadoutPeriod = 40;
+    constexpr std::size_t NumReadouts = 6;
+    const RegisterTrace trace(program);
+    const auto readouts = trace.every(ReadoutPeriod, FirstReadout) | std::views::take(NumReadouts);
+    const auto sumSignalStrength = trace.signalStrength(readouts);
+    assert(([&] {
+        std::int64_t sum = 0;
+        for (auto cycle : readouts) {
+            sum += static_cast<std::int64_t>(cycle) * trace.valueDuring(cycle);
         }
 
-        ++clockCycle;
-        if (clockCycle % ScreenWidth == 0) {
-            std::cout << std::endl;
+        return sum == sumSignalStrength;
+    }()));
+    Framebuffer screen(ScreenWidth, (trace.numCycles() + ScreenWidth - 1) / ScreenWidth);
+    screen.render(trace);
+    std::cout << screen.toText() << std::endl << "sum of signal strengths " << sumSignalStrength << std::endl;
+    if (argc > 2) {
+        std::ofstream pbm(argv[2], std::ios::binary);
+        if (not pbm.is_open()) {
+            std::cerr << "unable to open file '" << argv[2] << "'" << std::endl;
+            return 1;
         }
 
-        if (nextReadout != readouts.end() && clockCycle == *nextReadout) {
-            ++nextReadout;
-            unsigned signalStrength = clockCycle * regX;
-            sumSignalStrength += signalStrength;
-        }
-
-        if (clockCycle == instructions.front().finished) {
-            instructions.front().exec(regX);
-            instructions.pop_front();
-        }
+        screen.writePbm(pbm);
     }
-
-    std::cout << std::endl << "sum of signal strengths " << sumSignalStrength << std::endl;
 }
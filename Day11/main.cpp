@@ -1,72 +1,93 @@
 #include <string>
 #include <iostream>
 #include <vector>
-#include <optional>
 #include <cassert>
-#include <functional>
+#include <variant>
+#include <stdexcept>
+#include <array>
 #include <algorithm>
+#include <thread>
+#include <iterator>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <concepts>
+#include <string_view>
+#include <optional>
+#include <utility>
+#include <Iterators.hpp>
 #include "../util/util.hpp"
 
 
 using Item = unsigned long;
 
-class BinaryExpression {
-    using operator_ = std::function<Item(Item, Item)>;
-public:
-    explicit BinaryExpression(const std::string &line) {
-        auto parts = util::splitString<'='>(line);
-        assert(parts.size() == 2);
-        parts = util::splitString<' '>(parts.back());
-        assert(parts.size() == 3);
-        lhs = parseOperand(parts.front());
-        op = parseOperator(parts[1]);
-        rhs = parseOperand(parts.back());
+struct AddConst {
+    template<typename W>
+    constexpr W operator()(const W &old) const noexcept {
+        return old + value;
     }
 
-    [[nodiscard]] Item evaluate(Item input) const noexcept {
-        return op(lhs.value_or(input), rhs.value_or(input));
+    Item value;
+};
+
+struct MulConst {
+    template<typename W>
+    constexpr W operator()(const W &old) const noexcept {
+        return old * value;
     }
 
-private:
-    [[nodiscard]] static auto parseOperand(const std::string &input) noexcept -> std::optional<Item> {
-        std::optional<Item> ret;
-        try {
-            ret = std::stoi(input);
-        } catch (const std::invalid_argument &) {
+    Item value;
+};
 
+struct Square {
+    template<typename W>
+    constexpr W operator()(const W &old) const noexcept {
+        return old * old;
+    }
+};
+
+/**
+ * Closed set of update kernels. Dispatch happens once per batch of items, not per item
+ */
+using Operation = std::variant<AddConst, MulConst, Square>;
+
+auto parseOperation(const std::string &line) -> Operation {
+    auto parts = util::splitString<'='>(line);
+    assert(parts.size() == 2);
+    parts = util::splitString<' '>(parts.back());
+    assert(parts.size() == 3);
+    const auto &lhs = parts.front();
+    const auto &op = parts[1];
+    const auto &rhs = parts.back();
+    if (lhs != "old") {
+        if (rhs != "old") {
+            throw std::runtime_error("operation does not depend on old value: " + line);
         }
 
-        return ret;
+        return parseOperation("new = " + rhs + " " + op + " " + lhs);
     }
 
-    static operator_ parseOperator(const std::string &input) noexcept {
-        if (input == "+") {
-            return [](auto a, auto b) { return a + b; };
-        } else if (input == "-") {
-            return [](auto a, auto b) { return a - b; };
-        } else if (input == "*") {
-            return [](auto a, auto b) { return a * b; };
-        } else if (input == "/") {
-            return [](auto a, auto b) { return a / b; };
-        } else {
-            abort();
-        }
+    if (op == "+") {
+        return rhs == "old" ? Operation(MulConst{2}) : AddConst{std::stoul(rhs)};
+    } else if (op == "*") {
+        return rhs == "old" ? Operation(Square{}) : MulConst{std::stoul(rhs)};
     }
 
-    operator_ op;
-    std::optional<Item> lhs, rhs;
-};
+    throw std::runtime_error("unsupported operation: " + line);
+}
 
 struct ThrownItem {
     constexpr ThrownItem(Item val, unsigned target) noexcept: val(val), target(target) {}
+
+    constexpr bool operator==(const ThrownItem &other) const noexcept = default;
+
     Item val;
     unsigned target;
 };
 
 class Monkey {
-    using decay = std::function<Item(Item)>;
 public:
-    explicit Monkey(const std::array<std::string, 6> &definition) : updateFunction(definition[2]), divTest(
+    explicit Monkey(const std::array<std::string, 6> &definition) : updateFunction(parseOperation(definition[2])), divTest(
             parseIntegerAtEnd(definition[3])), trueTarget(parseIntegerAtEnd(definition[4])), falseTarget(
             parseIntegerAtEnd(definition[5])) {
         std::string _;
@@ -81,23 +102,31 @@ public:
         }
     }
 
-    auto throwStuff() -> std::vector<ThrownItem> {
+    template<typename Decay>
+    auto throwStuff(const Decay &decay) -> std::vector<ThrownItem> {
         std::vector<ThrownItem> ret;
         ret.reserve(items.size());
         inspectedItems += items.size();
-        for (auto item: items) {
-            auto newRes = decayFunction.value_or(std::identity{})(updateFunction.evaluate(item));
-            if (newRes % divTest == 0) {
-                ret.emplace_back(newRes, trueTarget);
-            } else {
-                ret.emplace_back(newRes, falseTarget);
+        std::visit([this, &ret, &decay](const auto &update) {
+            for (auto item: items) {
+                auto newRes = decay(update(item));
+                ret.emplace_back(newRes, newRes % divTest == 0 ? trueTarget : falseTarget);
             }
-        }
+        }, updateFunction);
 
         items.clear();
         return ret;
     }
 
+    /**
+     * Inspects a single item without changing the monkey's state
+     */
+    template<typename Decay>
+    [[nodiscard]] auto inspect(Item item, const Decay &decay) const -> ThrownItem {
+        auto newRes = std::visit([item, &decay](const auto &update) { return decay(update(item)); }, updateFunction);
+        return {newRes, newRes % divTest == 0 ? trueTarget : falseTarget};
+    }
+
     void catchItem(Item val) {
         items.emplace_back(val);
     }
@@ -110,9 +139,16 @@ public:
         return divTest;
     }
 
-    template<typename F>
-    void setDecayFunction(F &&fun) {
-        decayFunction = std::forward<F>(fun);
+    [[nodiscard]] auto getItems() const noexcept -> const std::vector<Item> & {
+        return items;
+    }
+
+    [[nodiscard]] constexpr auto getOperation() const noexcept -> const Operation & {
+        return updateFunction;
+    }
+
+    [[nodiscard]] constexpr unsigned getTarget(bool divisible) const noexcept {
+        return divisible ? trueTarget : falseTarget;
     }
 
 private:
@@ -124,43 +160,691 @@ private:
 
     unsigned id{};
     std::vector<Item> items;
-    BinaryExpression updateFunction;
+    Operation updateFunction;
     unsigned divTest, trueTarget, falseTarget;
     unsigned long inspectedItems = 0;
-    std::optional<decay> decayFunction;
 };
 
-template<typename F>
-void run(std::vector<Monkey> monkeys, const F &decayFun, unsigned numRounds) {
-    for (auto  &m : monkeys) {
-        m.setDecayFunction(decayFun);
-    }
+using Activities = std::vector<unsigned long>;
+
+unsigned long monkeyBusiness(Activities activities) {
+    std::ranges::partial_sort(activities, activities.begin() + 2, std::ranges::greater{});
+    return activities[0] * activities[1];
+}
 
+/**
+ * Reference simulation, round by round and monkey by monkey
+ */
+template<typename Decay>
+auto run(std::vector<Monkey> monkeys, const Decay &decay, unsigned numRounds) -> Activities {
     for (unsigned round = 1; round <= numRounds; ++round) {
         for (auto &monkey: monkeys) {
-            auto thrownItems = monkey.throwStuff();
+            auto thrownItems = monkey.throwStuff(decay);
             for (auto [val, target]: thrownItems) {
                 monkeys[target].catchItem(val);
             }
         }
     }
 
-    std::ranges::sort(monkeys, [](const auto &a, const auto &b) { return a.getActivity() > b.getActivity(); });
-    std::cout << "monkey business " << monkeys[0].getActivity() * monkeys[1].getActivity() << std::endl;
+    Activities ret;
+    std::ranges::transform(monkeys, std::back_inserter(ret), [](const auto &m) { return m.getActivity(); });
+    return ret;
+}
+
+/**
+ * Advances a single item by one round. Within a round, an item thrown to a monkey with a higher index is inspected
+ * again in the same round
+ * @param item current worry value and monkey holding the item
+ * @param activities inspections are counted here
+ * @return item state at the start of the next round
+ */
+template<typename Decay>
+auto itemRound(const std::vector<Monkey> &monkeys, ThrownItem item, const Decay &decay, Activities &activities)
+        -> ThrownItem {
+    unsigned previous;
+    do {
+        ++activities[item.target];
+        previous = item.target;
+        item = monkeys[item.target].inspect(item.val, decay);
+    } while (item.target > previous);
+
+    return item;
+}
+
+/**
+ * Items never interact, only the activity counters are shared. Calls fun(item, activities) for every item, items are
+ * distributed over threads, each thread counts into its own activities which are reduced at the end.
+ */
+template<typename F>
+auto forEachItemParallel(const std::vector<Monkey> &monkeys, unsigned numThreads, const F &fun) -> Activities {
+    std::vector<ThrownItem> items;
+    for (auto [idx, monkey] : iterators::const_enumerate(monkeys)) {
+        for (auto item : monkey.getItems()) {
+            items.emplace_back(item, idx);
+        }
+    }
+
+    numThreads = std::clamp<unsigned>(numThreads, 1, std::max<std::size_t>(items.size(), 1));
+    std::vector<Activities> threadActivities(numThreads, Activities(monkeys.size(), 0));
+    std::vector<std::thread> workers;
+    const auto chunk = (items.size() + numThreads - 1) / numThreads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (auto i = t * chunk; i < std::min(items.size(), (t + 1) * chunk); ++i) {
+                fun(items[i], threadActivities[t]);
+            }
+        });
+    }
+
+    Activities ret(monkeys.size(), 0);
+    for (auto [worker, activities] : iterators::zip(workers, threadActivities)) {
+        worker.join();
+        std::ranges::transform(ret, activities, ret.begin(), std::plus{});
+    }
+
+    return ret;
+}
+
+/**
+ * Simulates each item through all rounds independently of the others (see forEachItemParallel), but skips rounds
+ * once an item's trajectory becomes periodic. With a bounded decay (e.g. worry mod the product of all divisors), an
+ * item's state at round boundaries lives in a finite space and eventually cycles. Brent's algorithm finds the start mu
+ * and length lambda of the cycle, the inspections of the remaining rounds are then extrapolated from one pass through
+ * the cycle. If no cycle is found within numRounds rounds, the rounds simulated during the search already are the
+ * result.
+ */
+template<typename Decay>
+auto runWithCycleDetection(const std::vector<Monkey> &monkeys, const Decay &decay, unsigned long numRounds,
+                           unsigned numThreads = std::thread::hardware_concurrency()) -> Activities {
+    return forEachItemParallel(monkeys, numThreads, [&](const ThrownItem start, Activities &activities) {
+        if (numRounds == 0) {
+            return;
+        }
+
+        Activities scratch(monkeys.size(), 0);
+        Activities direct(monkeys.size(), 0);
+        // Brent's cycle search. The hare walks the trajectory step by step, so its inspections are exactly those of a
+        // direct simulation
+        unsigned long power = 1, lambda = 1, hareRounds = 1;
+        auto tortoise = start;
+        auto hare = itemRound(monkeys, start, decay, direct);
+        while (tortoise != hare) {
+            if (hareRounds == numRounds) {
+                std::ranges::transform(activities, direct, activities.begin(), std::plus{});
+                return;
+            }
+
+            if (power == lambda) {
+                tortoise = hare;
+                power *= 2;
+                lambda = 0;
+            }
+
+            hare = itemRound(monkeys, hare, decay, direct);
+            ++lambda;
+            ++hareRounds;
+        }
+
+        unsigned long mu = 0;
+        tortoise = hare = start;
+        for (unsigned long i = 0; i < lambda; ++i) {
+            hare = itemRound(monkeys, hare, decay, scratch);
+        }
+
+        while (tortoise != hare) {
+            tortoise = itemRound(monkeys, tortoise, decay, scratch);
+            hare = itemRound(monkeys, hare, decay, scratch);
+            ++mu;
+        }
+
+        if (mu + lambda >= numRounds) {
+            auto item = start;
+            for (unsigned long round = 0; round < numRounds; ++round) {
+                item = itemRound(monkeys, item, decay, activities);
+            }
+
+            return;
+        }
+
+        const auto numCycles = (numRounds - mu) / lambda;
+        const auto remainder = (numRounds - mu) % lambda;
+        Activities cycle(monkeys.size(), 0);
+        auto item = start;
+        for (unsigned long round = 0; round < mu; ++round) {
+            item = itemRound(monkeys, item, decay, activities);
+        }
+
+        // the first remainder rounds of the cycle are passed once more after the last full cycle
+        for (unsigned long round = 0; round < lambda; ++round) {
+            if (round == remainder) {
+                std::ranges::transform(activities, cycle, activities.begin(), std::plus{});
+            }
+
+            item = itemRound(monkeys, item, decay, cycle);
+        }
+
+        for (auto [total, perCycle] : iterators::zip(activities, cycle)) {
+            total += numCycles * perCycle;
+        }
+    });
+}
+
+/**
+ * Distinct divisors of all monkeys, one lane per divisor. Unused lanes have divisor 1
+ */
+template<std::size_t Lanes>
+class ResidueBasis {
+public:
+    // products of two residues have to be exact in double precision
+    static constexpr Item MaxDivisor = Item(1) << 26;
+
+    explicit ResidueBasis(const std::vector<Monkey> &monkeys) {
+        divisors.fill(1);
+        std::size_t numLanes = 0;
+        for (const auto &m : monkeys) {
+            const Item d = m.getModul();
+            if (d == 0 || d >= MaxDivisor) {
+                throw std::invalid_argument("unsupported divisor " + std::to_string(d));
+            }
+
+            if (std::ranges::find(divisors.begin(), divisors.begin() + numLanes, d) != divisors.begin() + numLanes) {
+                continue;
+            }
+
+            if (numLanes == Lanes) {
+                throw std::invalid_argument("more than " + std::to_string(Lanes) + " distinct divisors");
+            }
+
+            divisors[numLanes++] = static_cast<double>(d);
+        }
+
+        std::ranges::transform(divisors, inverses.begin(), [](double d) { return 1.0 / d; });
+    }
+
+    [[nodiscard]] std::size_t lane(Item divisor) const {
+        return std::ranges::find(divisors, static_cast<double>(divisor)) - divisors.begin();
+    }
+
+    /**
+     * Reduces every lane of values modulo its divisor. Values have to be non-negative integers below 2^52
+     */
+    void reduce(std::array<double, Lanes> &values) const noexcept {
+        for (std::size_t i = 0; i < Lanes; ++i) {
+            auto v = values[i] - std::floor(values[i] * inverses[i]) * divisors[i];
+            v += v < 0 ? divisors[i] : 0;
+            v -= v >= divisors[i] ? divisors[i] : 0;
+            values[i] = v;
+        }
+    }
+
+    alignas(64) std::array<double, Lanes> divisors;
+    alignas(64) std::array<double, Lanes> inverses;
+};
+
+/**
+ * Worry value represented by its residues modulo each divisor of a ResidueBasis. Addition and multiplication work
+ * lane by lane on fixed size arrays (exact integers stored as double so the reduction vectorizes), divisibility by a
+ * monkey's divisor is a single lane read. Never overflows, no matter how many monkeys there are. Division is not
+ * supported, so this only works for decay-free (part two) semantics
+ */
+template<std::size_t Lanes>
+class ResidueWorry {
+public:
+    ResidueWorry() noexcept: residues{}, basis(nullptr) {}
+
+    ResidueWorry(Item value, const ResidueBasis<Lanes> &basis) noexcept: basis(&basis) {
+        residues = broadcast(value);
+    }
+
+    ResidueWorry operator+(Item value) const noexcept {
+        auto ret = *this;
+        const auto summand = broadcast(value);
+        for (std::size_t i = 0; i < Lanes; ++i) {
+            ret.residues[i] += summand[i];
+            ret.residues[i] -= ret.residues[i] >= basis->divisors[i] ? basis->divisors[i] : 0;
+        }
+
+        return ret;
+    }
+
+    ResidueWorry operator*(Item value) const noexcept {
+        return multiply(broadcast(value));
+    }
+
+    ResidueWorry operator*(const ResidueWorry &other) const noexcept {
+        return multiply(other.residues);
+    }
+
+    [[nodiscard]] Item residue(std::size_t lane) const noexcept {
+        return static_cast<Item>(residues[lane]);
+    }
+
+private:
+    [[nodiscard]] auto broadcast(Item value) const noexcept -> std::array<double, Lanes> {
+        std::array<double, Lanes> ret;
+        if (value >= ResidueBasis<Lanes>::MaxDivisor) {
+            for (std::size_t i = 0; i < Lanes; ++i) {
+                ret[i] = static_cast<double>(value % static_cast<Item>(basis->divisors[i]));
+            }
+
+            return ret;
+        }
+
+        ret.fill(static_cast<double>(value));
+        basis->reduce(ret);
+        return ret;
+    }
+
+    [[nodiscard]] ResidueWorry multiply(const std::array<double, Lanes> &factors) const noexcept {
+        auto ret = *this;
+        for (std::size_t i = 0; i < Lanes; ++i) {
+            ret.residues[i] *= factors[i];
+        }
+
+        basis->reduce(ret.residues);
+        return ret;
+    }
+
+    alignas(64) std::array<double, Lanes> residues;
+    const ResidueBasis<Lanes> *basis;
+};
+
+template<typename W>
+concept ResidueRepresentation = requires(const W &w) {
+    { w.residue(std::size_t{}) } -> std::same_as<Item>;
+};
+
+/**
+ * Round based simulation without heap allocations in steady state. The worry values of all items live in one array,
+ * monkeys only hold queues of item indices. The queues are preallocated to hold every item and reused each round: a
+ * monkey swaps its queue with the batch buffer, empties its queue and then processes the batch in separate passes
+ * (gather worry values, update, divisibility test, scatter to the target queues) so that the update and test loops run
+ * over contiguous memory.
+ */
+template<typename Worry = Item>
+class RoundEngine {
+public:
+    explicit RoundEngine(const std::vector<Monkey> &monkeys) requires std::same_as<Worry, Item>
+            : RoundEngine(monkeys, std::identity{}, [](const Monkey &m) -> Item { return m.getModul(); }) {}
+
+    template<std::size_t Lanes>
+    RoundEngine(const std::vector<Monkey> &monkeys, const ResidueBasis<Lanes> &basis)
+    requires std::same_as<Worry, ResidueWorry<Lanes>>
+            : RoundEngine(monkeys, [&basis](Item val) { return Worry(val, basis); },
+                          [&basis](const Monkey &m) -> Item { return basis.lane(m.getModul()); }) {}
+
+    template<typename Decay>
+    void round(const Decay &decay) {
+        for (std::size_t m = 0; m < monkeys.size(); ++m) {
+            const auto size = queueSizes[m];
+            std::swap(queues[m], batch);
+            queueSizes[m] = 0;
+            activities[m] += size;
+            for (std::size_t i = 0; i < size; ++i) {
+                batchWorry[i] = worry[batch[i]];
+            }
+
+            std::visit([this, size, &decay](const auto &update) {
+                for (std::size_t i = 0; i < size; ++i) {
+                    batchWorry[i] = decay(update(batchWorry[i]));
+                }
+            }, monkeys[m].getOperation());
+            const Item key = testKeys[m];
+            for (std::size_t i = 0; i < size; ++i) {
+                if constexpr (ResidueRepresentation<Worry>) {
+                    batchDivisible[i] = batchWorry[i].residue(key) == 0;
+                } else {
+                    batchDivisible[i] = batchWorry[i] % key == 0;
+                }
+            }
+
+            for (std::size_t i = 0; i < size; ++i) {
+                const auto item = batch[i];
+                const auto target = monkeys[m].getTarget(batchDivisible[i]);
+                worry[item] = batchWorry[i];
+                queues[target][queueSizes[target]++] = item;
+            }
+        }
+    }
+
+    template<typename Decay>
+    auto run(const Decay &decay, unsigned long numRounds) -> const Activities & {
+        for (unsigned long r = 0; r < numRounds; ++r) {
+            round(decay);
+        }
+
+        return activities;
+    }
+
+private:
+    /**
+     * @param makeWorry converts an initial item value into the worry representation
+     * @param testKey divisibility test key of a monkey: the divisor or the residue lane
+     */
+    template<typename MakeWorry, typename TestKey>
+    RoundEngine(const std::vector<Monkey> &monkeys, const MakeWorry &makeWorry, const TestKey &testKey)
+            : monkeys(monkeys), activities(monkeys.size(), 0) {
+        std::size_t numItems = 0;
+        for (const auto &monkey : monkeys) {
+            numItems += monkey.getItems().size();
+        }
+
+        queues.assign(monkeys.size(), std::vector<std::uint32_t>(numItems));
+        queueSizes.assign(monkeys.size(), 0);
+        batch.resize(numItems);
+        batchWorry.resize(numItems);
+        batchDivisible.resize(numItems);
+        for (auto [idx, monkey] : iterators::const_enumerate(monkeys)) {
+            testKeys.emplace_back(testKey(monkey));
+            for (auto item : monkey.getItems()) {
+                queues[idx][queueSizes[idx]++] = static_cast<std::uint32_t>(worry.size());
+                worry.emplace_back(makeWorry(item));
+            }
+        }
+    }
+
+    const std::vector<Monkey> &monkeys;
+    Activities activities;
+    std::vector<Item> testKeys;
+    std::vector<Worry> worry;
+    std::vector<std::vector<std::uint32_t>> queues;
+    std::vector<std::size_t> queueSizes;
+    std::vector<std::uint32_t> batch;
+    std::vector<Worry> batchWorry;
+    std::vector<std::uint8_t> batchDivisible;
+};
+
+/**
+ * Decay-free simulation with residue vector worry values. Picks the narrowest lane count that fits all distinct
+ * divisors
+ */
+auto runResidues(const std::vector<Monkey> &monkeys, unsigned long numRounds) -> Activities {
+    auto runLanes = [&]<std::size_t Lanes>(std::integral_constant<std::size_t, Lanes>) {
+        const ResidueBasis<Lanes> basis(monkeys);
+        return RoundEngine<ResidueWorry<Lanes>>(monkeys, basis).run(std::identity{}, numRounds);
+    };
+
+    std::vector<Item> divisors;
+    std::ranges::transform(monkeys, std::back_inserter(divisors), [](const auto &m) { return m.getModul(); });
+    std::ranges::sort(divisors);
+    const auto numDistinct = std::unique(divisors.begin(), divisors.end()) - divisors.begin();
+    if (numDistinct <= 8) {
+        return runLanes(std::integral_constant<std::size_t, 8>{});
+    } else if (numDistinct <= 16) {
+        return runLanes(std::integral_constant<std::size_t, 16>{});
+    } else if (numDistinct <= 32) {
+        return runLanes(std::integral_constant<std::size_t, 32>{});
+    }
+
+    return runLanes(std::integral_constant<std::size_t, 64>{});
+}
+
+/**
+ * Compile time path: a troop definition given as constexpr string is parsed during compilation and turned into a
+ * round function where every monkey's operation, divisor and targets are constants
+ */
+namespace compiled {
+    enum class OpKind {
+        Add, Mul, Square
+    };
+
+    constexpr std::size_t MaxStartingItems = 64;
+
+    struct MonkeyDef {
+        std::array<Item, MaxStartingItems> items{};
+        std::size_t numItems = 0;
+        OpKind kind = OpKind::Add;
+        Item operand = 0;
+        Item divisor = 1;
+        unsigned trueTarget = 0, falseTarget = 0;
+    };
+
+    constexpr bool isDigit(char c) noexcept {
+        return c >= '0' && c <= '9';
+    }
+
+    /**
+     * Parses all numbers in a line
+     */
+    template<typename F>
+    constexpr void forEachNumber(std::string_view line, F &&fun) {
+        for (std::size_t i = 0; i < line.size();) {
+            if (not isDigit(line[i])) {
+                ++i;
+                continue;
+            }
+
+            Item val = 0;
+            for (; i < line.size() && isDigit(line[i]); ++i) {
+                val = val * 10 + static_cast<Item>(line[i] - '0');
+            }
+
+            fun(val);
+        }
+    }
+
+    constexpr Item lastNumber(std::string_view line) {
+        Item ret = 0;
+        forEachNumber(line, [&ret](Item val) { ret = val; });
+        return ret;
+    }
+
+    constexpr std::string_view nextLine(std::string_view &rest) noexcept {
+        auto end = rest.find('\n');
+        auto ret = rest.substr(0, end);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+        return ret;
+    }
+
+    constexpr std::size_t countMonkeys(std::string_view input) {
+        std::size_t ret = 0;
+        while (not input.empty()) {
+            ret += nextLine(input).starts_with("Monkey");
+        }
+
+        return ret;
+    }
+
+    /**
+     * Same rules as ::parseOperation: operands may be swapped, only + and * are supported. Throwing makes the parse a
+     * compile error if it runs during constant evaluation
+     */
+    constexpr void parseOperation(std::string_view line, MonkeyDef &def) {
+        const auto eq = line.find('=');
+        if (eq == std::string_view::npos) {
+            throw std::runtime_error("invalid operation");
+        }
+
+        std::array<std::string_view, 3> tokens;
+        std::size_t numTokens = 0;
+        for (auto rest = line.substr(eq + 1); not rest.empty();) {
+            if (rest.front() == ' ') {
+                rest.remove_prefix(1);
+                continue;
+            }
+
+            if (numTokens == tokens.size()) {
+                throw std::runtime_error("invalid operation");
+            }
+
+            const auto end = std::min(rest.find(' '), rest.size());
+            tokens[numTokens++] = rest.substr(0, end);
+            rest.remove_prefix(end);
+        }
+
+        if (numTokens != tokens.size()) {
+            throw std::runtime_error("invalid operation");
+        }
+
+        auto [lhs, op, rhs] = tokens;
+        if (lhs != "old") {
+            if (rhs != "old") {
+                throw std::runtime_error("operation does not depend on old value");
+            }
+
+            std::swap(lhs, rhs);
+        }
+
+        if (op != "+" && op != "*") {
+            throw std::runtime_error("unsupported operation");
+        }
+
+        if (rhs == "old") {
+            def.kind = op == "+" ? OpKind::Mul : OpKind::Square;
+            def.operand = 2;
+        } else if (std::ranges::all_of(rhs, isDigit)) {
+            def.kind = op == "+" ? OpKind::Add : OpKind::Mul;
+            def.operand = lastNumber(rhs);
+        } else {
+            throw std::runtime_error("invalid operand");
+        }
+    }
+
+    template<std::size_t N>
+    constexpr auto parseTroop(std::string_view input) -> std::array<MonkeyDef, N> {
+        std::array<MonkeyDef, N> ret;
+        for (auto &def : ret) {
+            while (not nextLine(input).starts_with("Monkey")) {}
+            forEachNumber(nextLine(input), [&def](Item val) {
+                if (def.numItems == MaxStartingItems) {
+                    throw std::length_error("too many starting items");
+                }
+
+                def.items[def.numItems++] = val;
+            });
+
+            parseOperation(nextLine(input), def);
+            def.divisor = lastNumber(nextLine(input));
+            def.trueTarget = static_cast<unsigned>(lastNumber(nextLine(input)));
+            def.falseTarget = static_cast<unsigned>(lastNumber(nextLine(input)));
+        }
+
+        return ret;
+    }
+
+    /**
+     * @return product of all divisors or 0 if it exceeds 2^32 - 1 (worry values below it could not be squared)
+     */
+    template<std::size_t N>
+    constexpr Item productOfDivisors(const std::array<MonkeyDef, N> &troop) noexcept {
+        Item ret = 1;
+        for (const auto &def : troop) {
+            if (ret > std::numeric_limits<std::uint32_t>::max() / def.divisor) {
+                return 0;
+            }
+
+            ret *= def.divisor;
+        }
+
+        return ret;
+    }
+
+    /**
+     * Round simulation specialized for a troop known at compile time. Turns are unrolled over all monkeys, the
+     * operations and divisors are constants, so the compiler can strength-reduce the modulo operations
+     */
+    template<const auto &Troop>
+    class CompiledTroop {
+        static constexpr std::size_t N = Troop.size();
+        static_assert(std::ranges::all_of(Troop, [](const MonkeyDef &def) { return def.divisor != 0; }));
+        static_assert([]() {
+            for (std::size_t m = 0; m < N; ++m) {
+                if (Troop[m].trueTarget >= N || Troop[m].falseTarget >= N || Troop[m].trueTarget == m ||
+                    Troop[m].falseTarget == m) {
+                    return false;
+                }
+            }
+
+            return true;
+        }(), "invalid throw targets");
+    public:
+        CompiledTroop() : activities(N, 0) {
+            std::size_t numItems = 0;
+            for (const auto &def : Troop) {
+                numItems += def.numItems;
+            }
+
+            for (auto [queue, def] : iterators::zip(items, Troop)) {
+                queue.reserve(numItems);
+                queue.assign(def.items.begin(), def.items.begin() + def.numItems);
+            }
+        }
+
+        template<typename Decay>
+        auto run(const Decay &decay, unsigned long numRounds) -> const Activities & {
+            for (unsigned long round = 0; round < numRounds; ++round) {
+                [this, &decay]<std::size_t ...M>(std::index_sequence<M...>) {
+                    (turn<M>(decay), ...);
+                }(std::make_index_sequence<N>{});
+            }
+
+            return activities;
+        }
+
+    private:
+        template<std::size_t M, typename Decay>
+        void turn(const Decay &decay) {
+            constexpr const MonkeyDef &def = Troop[M];
+            activities[M] += items[M].size();
+            for (auto val : items[M]) {
+                if constexpr (def.kind == OpKind::Add) {
+                    val += def.operand;
+                } else if constexpr (def.kind == OpKind::Mul) {
+                    val *= def.operand;
+                } else {
+                    val *= val;
+                }
+
+                val = decay(val);
+                items[val % def.divisor == 0 ? def.trueTarget : def.falseTarget].emplace_back(val);
+            }
+
+            items[M].clear();
+        }
+
+        std::array<std::vector<Item>, N> items;
+        Activities activities;
+    };
+}
+
+#if __has_include("input.inc")
+constexpr std::string_view EmbeddedInput =
+#include "input.inc"
+;
+constexpr auto EmbeddedTroop = compiled::parseTroop<compiled::countMonkeys(EmbeddedInput)>(EmbeddedInput);
+#endif
+
+/**
+ * Runs both parts with the compile time specialized troop if input is the input embedded at build time
+ * @return activities of part one and part two, nothing if input differs, no input was embedded or the product of the
+ * divisors is too large to keep worry values modulo it
+ */
+auto runEmbedded([[maybe_unused]] std::string_view input) -> std::optional<std::pair<Activities, Activities>> {
+#if __has_include("input.inc")
+    constexpr auto Modul = compiled::productOfDivisors(EmbeddedTroop);
+    if constexpr (Modul != 0) {
+        if (input == EmbeddedInput) {
+            return std::pair{compiled::CompiledTroop<EmbeddedTroop>().run([](Item val) { return val / 3; }, 20),
+                             compiled::CompiledTroop<EmbeddedTroop>().run([](Item val) { return val % Modul; },
+                                                                          10000)};
+        }
+    }
+#endif
+    return {};
 }
 
 int main(int argc, char **argv) {
     auto file = util::getInputFile(argc, argv);
+    const std::string input(std::istreambuf_iterator<char>(file), {});
+    std::istringstream in(input);
     std::string line;
     std::array<std::string, 6> inputDef;
     auto defIt = inputDef.begin();
     std::vector<Monkey> monkeys;
-    unsigned modul = 1;
-    while (std::getline(file, line)) {
+    while (std::getline(in, line)) {
         if (line.empty()) {
             defIt = inputDef.begin();
             monkeys.emplace_back(inputDef);
-            modul *= monkeys.back().getModul();
             continue;
         }
 
@@ -170,9 +854,40 @@ int main(int argc, char **argv) {
 
     if (defIt == inputDef.end()) {
         monkeys.emplace_back(inputDef);
-        modul *= monkeys.back().getModul();
     }
 
-    run(monkeys, [](auto val) { return val / 3; }, 20);
-    run(monkeys, [modul](auto val) { return val % modul; }, 10000);
+    // worry values are kept below modul, squaring them must not overflow. Otherwise, worry is tracked via residues
+    Item modul = 1;
+    for (const auto &m : monkeys) {
+        if (modul > std::numeric_limits<std::uint32_t>::max() / m.getModul()) {
+            modul = 0;
+            break;
+        }
+
+        modul *= m.getModul();
+    }
+
+    auto decayPart1 = [](auto val) { return val / 3; };
+    auto decayPart2 = [modul](auto val) { return val % modul; };
+    if (auto embedded = runEmbedded(input)) {
+        assert(embedded->first == run(monkeys, decayPart1, 20));
+        assert(modul != 0 && embedded->second == run(monkeys, decayPart2, 10000));
+        assert(embedded->second == runResidues(monkeys, 10000));
+        std::cout << "monkey business " << monkeyBusiness(embedded->first) << std::endl;
+        std::cout << "monkey business " << monkeyBusiness(embedded->second) << std::endl;
+        return 0;
+    }
+
+    auto activities = RoundEngine(monkeys).run(decayPart1, 20);
+    assert(activities == run(monkeys, decayPart1, 20));
+    std::cout << "monkey business " << monkeyBusiness(activities) << std::endl;
+    if (modul != 0) {
+        activities = runWithCycleDetection(monkeys, decayPart2, 10000);
+        assert(activities == run(monkeys, decayPart2, 10000));
+        assert(activities == runResidues(monkeys, 10000));
+    } else {
+        activities = runResidues(monkeys, 10000);
+    }
+
+    std::cout << "monkey business " << monkeyBusiness(activities) << std::endl;
 }
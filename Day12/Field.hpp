@@ -0,0 +1,393 @@
+#ifndef AOC22_DAY12_FIELD_HPP
+#define AOC22_DAY12_FIELD_HPP
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <optional>
+#include <span>
+#include <cstdlib>
+#include <concepts>
+#include <ranges>
+#include <limits>
+#include <algorithm>
+#include <deque>
+#include <typeindex>
+#include <typeinfo>
+#include <type_traits>
+#include <bit>
+#include <cstdint>
+#include <Iterators.hpp>
+#include "../util/Grid.hpp"
+#include "Search.hpp"
+
+/**
+ * Constraints without state can be identified by their type, which allows caching derived data
+ */
+template<typename C>
+concept StatelessConstraint = std::is_empty_v<C> && std::default_initializable<C>;
+
+/**
+ * Four bits per cell, bit d is set if the move from the cell in direction Grid::Directions[d] stays inside the grid and
+ * is allowed by the elevation constraint. Two cells share a byte, addressed by the storage index of the terrain
+ */
+class ConnectivityMasks {
+public:
+    /**
+     * Computes the masks row by row. Each row and its neighbour rows are copied into contiguous buffers (padded by
+     * repeating the border cells), so the inner loop evaluates all four directions without branches; moves leaving the
+     * grid are cleared afterwards
+     */
+    template<typename Terrain, typename C>
+    ConnectivityMasks(const Terrain &terrain, const C &constraint) : nibbles((terrain.storageSize() + 1) / 2, 0) {
+        using H = std::remove_cvref_t<decltype(terrain[0])>;
+        using Coord = typename Terrain::Coord;
+        const auto w = terrain.width(), h = terrain.height();
+        if (w == 0 || h == 0) {
+            return;
+        }
+
+        std::vector<H> above(w + 2), current(w + 2), below(w + 2);
+        std::vector<std::uint8_t> rowMasks(w);
+        auto load = [&terrain, w](std::vector<H> &buffer, Coord y) {
+            std::ranges::copy(terrain.row(y), buffer.begin() + 1);
+            buffer.front() = buffer[1];
+            buffer.back() = buffer[w];
+        };
+
+        load(current, 0);
+        above = current;
+        for (Coord y = 0; y < static_cast<Coord>(h); ++y) {
+            if (y + 1 < static_cast<Coord>(h)) {
+                load(below, y + 1);
+            } else {
+                below = current;
+            }
+
+            for (std::size_t x = 0; x < w; ++x) {
+                const auto here = current[x + 1];
+                rowMasks[x] = static_cast<std::uint8_t>(
+                        static_cast<unsigned>(static_cast<bool>(constraint(current[x], here))) |
+                        static_cast<unsigned>(static_cast<bool>(constraint(current[x + 2], here))) << 1 |
+                        static_cast<unsigned>(static_cast<bool>(constraint(above[x + 1], here))) << 2 |
+                        static_cast<unsigned>(static_cast<bool>(constraint(below[x + 1], here))) << 3);
+            }
+
+            rowMasks.front() &= ~1u;
+            rowMasks.back() &= ~2u;
+            const std::uint8_t rowBorder = (y == 0 ? 4u : 0u) | (y + 1 == static_cast<Coord>(h) ? 8u : 0u);
+            for (std::size_t x = 0; x < w; ++x) {
+                set(terrain.index(static_cast<Coord>(x), y), rowMasks[x] & ~rowBorder);
+            }
+
+            above.swap(current);
+            current.swap(below);
+        }
+    }
+
+    [[nodiscard]] std::uint8_t operator[](std::size_t idx) const noexcept {
+        return (nibbles[idx / 2] >> (4 * (idx % 2))) & 0xF;
+    }
+
+    /**
+     * Recomputes the mask of a single cell, e.g. after the height of the cell or of one of its neighbours changed
+     */
+    template<typename Terrain, typename C>
+    void refresh(const Terrain &terrain, const C &constraint, std::size_t cell) {
+        const auto pos = terrain.position(cell);
+        std::uint8_t mask = 0;
+        for (std::size_t d = 0; d < Terrain::Directions.size(); ++d) {
+            const auto n = pos + Terrain::Directions[d];
+            if (terrain.contains(n) && constraint(terrain(n), terrain[cell])) {
+                mask |= static_cast<std::uint8_t>(1u << d);
+            }
+        }
+
+        set(cell, mask);
+    }
+
+private:
+    void set(std::size_t idx, std::uint8_t mask) noexcept {
+        const auto shift = 4 * (idx % 2);
+        nibbles[idx / 2] = static_cast<std::uint8_t>((nibbles[idx / 2] & ~(0xF << shift)) | (mask << shift));
+    }
+
+    std::vector<std::uint8_t> nibbles;
+};
+
+/**
+ * New height of a single cell given by its storage index
+ */
+struct TerrainUpdate {
+    std::size_t cell;
+    int height;
+};
+
+class Field {
+public:
+    using HType = int;
+    using Terrain = util::Grid<HType, util::Layout::Tiled>;
+    explicit Field(std::istream &in) {
+        std::string line;
+        std::vector<std::string> lines;
+        while (std::getline(in, line)) {
+            lines.emplace_back(std::move(line));
+        }
+
+        terrain = Terrain(lines.front().size(), lines.size());
+        for (auto [row, l] : iterators::const_enumerate(lines)) {
+            for (auto [col, c] : iterators::const_enumerate(l)) {
+                auto val = c - 'a';
+                auto idx = terrain.index(col, row);
+                if (c == 'S') {
+                    start = idx;
+                    val = 0;
+                } else if (c == 'E') {
+                    goal = idx;
+                    val = 'z' - 'a';
+                }
+
+                if (val == 0) {
+                    startingPoints.emplace_back(idx);
+                }
+
+                terrain[idx] = val;
+            }
+        }
+    }
+
+    /**
+     * Sets the heights of the given cells and keeps startingPoints up to date
+     */
+    void update(std::span<const TerrainUpdate> changes) {
+        for (const auto &[cell, height] : changes) {
+            if (terrain[cell] == 0 && height != 0) {
+                std::erase(startingPoints, cell);
+            } else if (terrain[cell] != 0 && height == 0) {
+                startingPoints.emplace_back(cell);
+            }
+
+            terrain[cell] = height;
+        }
+
+        for (auto &entry : maskCache) {
+            for (const auto &change : changes) {
+                entry.refresh(entry.masks, terrain, change.cell);
+                for (const auto &n : terrain.neighbours(terrain.position(change.cell))) {
+                    entry.refresh(entry.masks, terrain, terrain.index(n));
+                }
+            }
+        }
+    }
+
+    /**
+     * Passability masks of the terrain under the constraint. Computed on first use, cached and kept up to date by
+     * update(). Not thread safe
+     */
+    template<StatelessConstraint C>
+    [[nodiscard]] const ConnectivityMasks &masks() const {
+        for (const auto &entry : maskCache) {
+            if (entry.type == typeid(C)) {
+                return entry.masks;
+            }
+        }
+
+        return maskCache.emplace_back(typeid(C), ConnectivityMasks(terrain, C{}), &refreshCell<C>).masks;
+    }
+
+    [[nodiscard]] unsigned dist(std::size_t a, std::size_t b) const noexcept {
+        auto diff = terrain.position(a) - terrain.position(b);
+        return std::abs(diff.x) + std::abs(diff.y);
+    }
+
+    std::size_t start;
+    std::size_t goal;
+    Terrain terrain{};
+    std::vector<std::size_t> startingPoints;
+
+private:
+    struct CachedMasks {
+        CachedMasks(std::type_index type, ConnectivityMasks masks,
+                    void (*refresh)(ConnectivityMasks &, const Terrain &, std::size_t)) :
+                type(type), masks(std::move(masks)), refresh(refresh) {}
+
+        std::type_index type;
+        ConnectivityMasks masks;
+        void (*refresh)(ConnectivityMasks &, const Terrain &, std::size_t);
+    };
+
+    template<StatelessConstraint C>
+    static void refreshCell(ConnectivityMasks &masks, const Terrain &terrain, std::size_t cell) {
+        masks.refresh(terrain, C{}, cell);
+    }
+
+    // deque: references returned by masks() stay valid when further entries are added
+    mutable std::deque<CachedMasks> maskCache;
+};
+
+template<typename E>
+concept ElevationConstraint = requires(E instance, Field::HType height) {
+    { instance(height, height) } -> std::convertible_to<bool>;
+};
+
+/**
+ * Puzzle rule: the next cell may be at most one higher than the current one
+ */
+struct Climb {
+    constexpr bool operator()(Field::HType newHeight, Field::HType oldHeight) const noexcept {
+        return newHeight - oldHeight <= 1;
+    }
+};
+
+/**
+ * @return callback expand function for searches on the field. Calls fun for all neighbours (inside the grid) that
+ * can be reached under the constraint without any allocation. Stateless constraints use the cached passability masks
+ * of the field and only visit the set bits
+ */
+template<ElevationConstraint ElevationTest>
+auto expandUnder(const Field &field, const ElevationTest &elevationTest) {
+    if constexpr (StatelessConstraint<ElevationTest>) {
+        return [&field, &masks = field.masks<ElevationTest>()](std::size_t pos, auto &&fun) {
+            const auto mask = masks[pos];
+            if (mask == 0) {
+                return;
+            }
+
+            const auto p = field.terrain.position(pos);
+            for (auto m = static_cast<unsigned>(mask); m != 0; m &= m - 1) {
+                fun(field.terrain.index(p + Field::Terrain::Directions[std::countr_zero(m)]));
+            }
+        };
+    } else {
+        return [&field, &elevationTest](std::size_t pos, auto &&fun) {
+            const auto height = field.terrain[pos];
+            for (const auto &n : field.terrain.neighbours(field.terrain.position(pos))) {
+                const auto idx = field.terrain.index(n);
+                if (elevationTest(field.terrain[idx], height)) {
+                    fun(idx);
+                }
+            }
+        };
+    }
+}
+
+template<GoalTest<std::size_t> GoalFun, ElevationConstraint ElevationTest, HeuristicFunction<std::size_t> H,
+        Fringe Fr = BinaryHeapFringe>
+unsigned shortestPath(std::size_t start, const Field &field, const GoalFun &goalTest, const ElevationTest &elevationTest, H &&h,
+                      Fr fringe = {}) {
+    auto expand = expandUnder(field, elevationTest);
+    auto res = aStar(start, goalTest, expand, std::forward<H>(h), DenseIndex{field.terrain.storageSize()},
+                     std::move(fringe));
+    if (res.has_value()) {
+        return res->pathCost();
+    }
+
+    std::cerr << "unsolvable" << std::endl;
+    std::exit(1);
+}
+
+/**
+ * Evaluates an elevation constraint for moves in the opposite direction. Searching forward under Reversed<C> from a
+ * cell yields the cells that can reach it under C
+ */
+template<ElevationConstraint C>
+struct Reversed {
+    constexpr bool operator()(Field::HType newHeight, Field::HType oldHeight) const {
+        return constraint(oldHeight, newHeight);
+    }
+
+    [[no_unique_address]] C constraint;
+};
+
+/**
+ * Shortest path between two cells by bidirectional search: forward under the constraint from start, backward under
+ * the reversed constraint from goal
+ */
+template<ElevationConstraint C>
+auto bidirectionalShortestPath(const Field &field, std::size_t start, std::size_t goal, const C &constraint)
+        -> std::optional<unsigned> {
+    const Reversed<C> reversed{constraint};
+    auto res = bidirectionalSearch(start, goal, expandUnder(field, constraint), expandUnder(field, reversed),
+                                   DenseIndex{field.terrain.storageSize()});
+    if (res.has_value()) {
+        return res->pathCost();
+    }
+
+    return {};
+}
+
+/**
+ * Distances of all cells to a fixed target cell under an elevation constraint, computed by a single breadth first
+ * search from the target under the reversed constraint. Afterwards, every distance query is a lookup
+ */
+class DistanceField {
+public:
+    static constexpr unsigned Unreachable = std::numeric_limits<unsigned>::max();
+
+    /**
+     * @param distances distance per storage index of the terrain
+     */
+    explicit DistanceField(std::vector<unsigned> distances) : distances(std::move(distances)) {}
+
+    template<ElevationConstraint C>
+    static auto toTarget(const Field &field, std::size_t target, const C &constraint) -> DistanceField {
+        const Reversed<C> reversed{constraint};
+        std::vector<unsigned> distances(field.terrain.storageSize(), Unreachable);
+        std::vector<std::size_t> queue;
+        queue.reserve(field.terrain.width() * field.terrain.height());
+        queue.emplace_back(target);
+        distances[target] = 0;
+        const auto expand = expandUnder(field, reversed);
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const auto current = queue[head];
+            expand(current, [&](std::size_t idx) {
+                if (distances[idx] == Unreachable) {
+                    distances[idx] = distances[current] + 1;
+                    queue.emplace_back(idx);
+                }
+            });
+        }
+
+        return DistanceField(std::move(distances));
+    }
+
+    /**
+     * @return number of steps from the cell with the given storage index to the target or Unreachable
+     */
+    [[nodiscard]] unsigned operator[](std::size_t idx) const noexcept {
+        return distances[idx];
+    }
+
+    bool operator==(const DistanceField &other) const = default;
+
+    /**
+     * @return for each given storage index the number of steps to the target
+     */
+    template<std::ranges::input_range R>
+    [[nodiscard]] auto query(R &&cells) const -> std::vector<unsigned> {
+        std::vector<unsigned> ret;
+        for (auto idx : cells) {
+            ret.emplace_back(distances[idx]);
+        }
+
+        return ret;
+    }
+
+    /**
+     * @return minimum number of steps from any of the given cells to the target or Unreachable
+     */
+    template<std::ranges::input_range R>
+    [[nodiscard]] unsigned nearest(R &&cells) const {
+        unsigned ret = Unreachable;
+        for (auto idx : cells) {
+            ret = std::min(ret, distances[idx]);
+        }
+
+        return ret;
+    }
+
+private:
+    std::vector<unsigned> distances;
+};
+
+#endif //AOC22_DAY12_FIELD_HPP
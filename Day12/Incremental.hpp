@@ -0,0 +1,147 @@
+#ifndef AOC22_DAY12_INCREMENTAL_HPP
+#define AOC22_DAY12_INCREMENTAL_HPP
+
+#include <vector>
+#include <span>
+#include <queue>
+#include <functional>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+#include "Field.hpp"
+
+/**
+ * Lifelong Planning A* (Koenig, Likhachev) between two fixed cells of a field. The engine keeps, for each cell, the
+ * path cost g from the last search and its one step lookahead rhs. After terrain updates only cells whose edges
+ * changed are re-evaluated, and the next query only re-expands cells that became inconsistent, so the cost of a
+ * repair is proportional to the affected region instead of the whole grid.
+ */
+template<ElevationConstraint C>
+class IncrementalSearch {
+    static constexpr unsigned Infinity = std::numeric_limits<unsigned>::max();
+
+    struct Key {
+        unsigned f, g;
+
+        constexpr auto operator<=>(const Key &other) const noexcept = default;
+    };
+
+    struct QueueEntry {
+        Key key;
+        std::size_t cell;
+
+        constexpr bool operator>(const QueueEntry &other) const noexcept {
+            return key > other.key;
+        }
+    };
+
+public:
+    static constexpr unsigned Unreachable = Infinity;
+
+    IncrementalSearch(Field &field, std::size_t start, std::size_t goal, C constraint) :
+            field(field), start(start), goal(goal), constraint(std::move(constraint)),
+            g(field.terrain.storageSize(), Infinity), rhs(field.terrain.storageSize(), Infinity) {
+        rhs[start] = 0;
+        queue.push({calculateKey(start), start});
+    }
+
+    /**
+     * @return length of the shortest path from start to goal or Unreachable. Only repairs what changed since the last
+     * call
+     */
+    unsigned pathCost() {
+        computeShortestPath();
+        return g[goal];
+    }
+
+    /**
+     * Applies the updates to the terrain and marks all cells with changed incoming edges for re-evaluation
+     */
+    void update(std::span<const TerrainUpdate> changes) {
+        field.update(changes);
+        for (const auto &change : changes) {
+            updateCell(change.cell);
+            for (const auto &n : field.terrain.neighbours(field.terrain.position(change.cell))) {
+                updateCell(field.terrain.index(n));
+            }
+        }
+    }
+
+    /**
+     * @return number of cells expanded by all searches so far
+     */
+    [[nodiscard]] std::size_t numExpanded() const noexcept {
+        return expanded;
+    }
+
+private:
+    [[nodiscard]] Key calculateKey(std::size_t cell) const noexcept {
+        const auto cost = std::min(g[cell], rhs[cell]);
+        return {cost == Infinity ? Infinity : cost + field.dist(cell, goal), cost};
+    }
+
+    [[nodiscard]] bool passable(std::size_t from, std::size_t to) const {
+        return constraint(field.terrain[to], field.terrain[from]);
+    }
+
+    void updateCell(std::size_t cell) {
+        if (cell != start) {
+            rhs[cell] = Infinity;
+            for (const auto &n : field.terrain.neighbours(field.terrain.position(cell))) {
+                const auto pred = field.terrain.index(n);
+                if (g[pred] != Infinity && passable(pred, cell)) {
+                    rhs[cell] = std::min(rhs[cell], g[pred] + 1);
+                }
+            }
+        }
+
+        if (g[cell] != rhs[cell]) {
+            queue.push({calculateKey(cell), cell});
+        }
+    }
+
+    /**
+     * Removes queue entries of cells that became consistent or were re-queued with a different key since
+     */
+    void dropStaleEntries() {
+        while (not queue.empty()) {
+            const auto &[key, cell] = queue.top();
+            if (g[cell] != rhs[cell] && key == calculateKey(cell)) {
+                return;
+            }
+
+            queue.pop();
+        }
+    }
+
+    void computeShortestPath() {
+        for (dropStaleEntries(); not queue.empty() && (queue.top().key < calculateKey(goal) || rhs[goal] != g[goal]);
+             dropStaleEntries()) {
+            const auto cell = queue.top().cell;
+            queue.pop();
+            ++expanded;
+            if (g[cell] > rhs[cell]) {
+                g[cell] = rhs[cell];
+            } else {
+                g[cell] = Infinity;
+                updateCell(cell);
+            }
+
+            for (const auto &n : field.terrain.neighbours(field.terrain.position(cell))) {
+                const auto succ = field.terrain.index(n);
+                if (passable(cell, succ)) {
+                    updateCell(succ);
+                }
+            }
+        }
+    }
+
+    Field &field;
+    std::size_t start, goal;
+    C constraint;
+    std::vector<unsigned> g, rhs;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> queue;
+    std::size_t expanded = 0;
+};
+
+#endif //AOC22_DAY12_INCREMENTAL_HPP
@@ -0,0 +1,202 @@
+#ifndef AOC22_DAY12_PARALLELBFS_HPP
+#define AOC22_DAY12_PARALLELBFS_HPP
+
+#include <vector>
+#include <thread>
+#include <barrier>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "Field.hpp"
+
+/**
+ * One bit per storage index of the terrain. The *Atomic members may be used concurrently on the same word
+ */
+class CellBitmap {
+public:
+    explicit CellBitmap(std::size_t numCells) : bits((numCells + 63) / 64, 0) {}
+
+    [[nodiscard]] bool test(std::size_t idx) const noexcept {
+        return (bits[idx / 64] >> (idx % 64)) & 1u;
+    }
+
+    [[nodiscard]] bool testAtomic(std::size_t idx) noexcept {
+        return (std::atomic_ref(bits[idx / 64]).load(std::memory_order_relaxed) >> (idx % 64)) & 1u;
+    }
+
+    void set(std::size_t idx) noexcept {
+        bits[idx / 64] |= std::uint64_t(1) << (idx % 64);
+    }
+
+    void setAtomic(std::size_t idx) noexcept {
+        std::atomic_ref(bits[idx / 64]).fetch_or(std::uint64_t(1) << (idx % 64), std::memory_order_relaxed);
+    }
+
+    /**
+     * @return true if the bit was set before, i.e. if the caller cleared it
+     */
+    bool clearAtomic(std::size_t idx) noexcept {
+        const auto mask = std::uint64_t(1) << (idx % 64);
+        return std::atomic_ref(bits[idx / 64]).fetch_and(~mask, std::memory_order_relaxed) & mask;
+    }
+
+    [[nodiscard]] std::size_t numWords() const noexcept {
+        return bits.size();
+    }
+
+    [[nodiscard]] std::uint64_t word(std::size_t w) const noexcept {
+        return bits[w];
+    }
+
+    std::uint64_t &word(std::size_t w) noexcept {
+        return bits[w];
+    }
+
+    /**
+     * Calls fun(idx) for each set bit in words [from, to)
+     */
+    template<typename F>
+    void forEachSet(std::size_t from, std::size_t to, F &&fun) const {
+        for (auto w = from; w < to; ++w) {
+            for (auto word = bits[w]; word != 0; word &= word - 1) {
+                fun(w * 64 + std::countr_zero(word));
+            }
+        }
+    }
+
+private:
+    std::vector<std::uint64_t> bits;
+};
+
+/**
+ * Level synchronous breadth first search from the target under the reversed elevation constraint, yielding the same
+ * distances as DistanceField::toTarget. Each level is processed either top-down (frontier cells claim their unvisited
+ * neighbours) or bottom-up (unvisited cells look for a neighbour in the frontier), switching between both depending on
+ * the size of the frontier relative to the unvisited cells (Beamer et al.). Top-down levels keep the frontier as a list
+ * of cells so that their cost is proportional to the frontier, bottom-up levels use bitmap frontiers. The list or the
+ * bitmap words are split evenly across a fixed set of worker threads that synchronize once per level.
+ */
+template<ElevationConstraint C>
+auto parallelDistanceField(const Field &field, std::size_t target, const C &constraint,
+                           std::size_t numThreads = std::thread::hardware_concurrency()) -> DistanceField {
+    // switch to bottom-up if frontier * Alpha > unvisited, back to top-down if frontier * Beta < cells and shrinking
+    constexpr std::size_t Alpha = 14;
+    constexpr std::size_t Beta = 24;
+    const Reversed<C> reversed{constraint};
+    const auto &terrain = field.terrain;
+    const auto numCells = terrain.width() * terrain.height();
+    std::vector<unsigned> distances(terrain.storageSize(), DistanceField::Unreachable);
+    CellBitmap unvisited(terrain.storageSize()), frontier(terrain.storageSize()), next(terrain.storageSize());
+    for (Field::Terrain::Coord y = 0; y < static_cast<Field::Terrain::Coord>(terrain.height()); ++y) {
+        for (Field::Terrain::Coord x = 0; x < static_cast<Field::Terrain::Coord>(terrain.width()); ++x) {
+            unvisited.set(terrain.index(x, y));
+        }
+    }
+
+    distances[target] = 0;
+    unvisited.clearAtomic(target);
+    std::vector<std::size_t> frontierCells{target};
+    const auto numWords = frontier.numWords();
+    numThreads = std::clamp<std::size_t>(numThreads, 1, numWords);
+    const std::size_t chunk = (numWords + numThreads - 1) / numThreads;
+    numThreads = (numWords + chunk - 1) / chunk;
+    // cells found by each worker during a top-down level
+    std::vector<std::vector<std::size_t>> found(numThreads);
+    std::size_t frontierSize = 1, unvisitedSize = numCells - 1;
+    unsigned level = 0;
+    bool bottomUp = false, done = false;
+    std::atomic<std::size_t> nextSize = 0;
+    // builds the frontier of the next level in the representation the next level needs
+    auto nextLevel = [&]() noexcept {
+        const auto size = nextSize.exchange(0);
+        const bool wasBottomUp = bottomUp;
+        unvisitedSize -= size;
+        if (not bottomUp && size * Alpha > unvisitedSize) {
+            bottomUp = true;
+        } else if (bottomUp && size * Beta < numCells && size < frontierSize) {
+            bottomUp = false;
+        }
+
+        if (wasBottomUp && bottomUp) {
+            std::swap(frontier, next);
+        } else if (wasBottomUp) {
+            frontierCells.clear();
+            next.forEachSet(0, numWords, [&frontierCells](std::size_t idx) { frontierCells.emplace_back(idx); });
+        } else {
+            frontierCells.clear();
+            for (auto &cells : found) {
+                frontierCells.insert(frontierCells.end(), cells.begin(), cells.end());
+                cells.clear();
+            }
+
+            if (bottomUp) {
+                std::fill(&frontier.word(0), &frontier.word(0) + numWords, 0);
+                for (auto idx : frontierCells) {
+                    frontier.set(idx);
+                }
+            }
+        }
+
+        frontierSize = size;
+        done = size == 0;
+        ++level;
+    };
+
+    std::barrier levelDone(static_cast<std::ptrdiff_t>(numThreads), nextLevel);
+    auto worker = [&](std::size_t t, std::size_t from, std::size_t to) {
+        while (not done) {
+            std::size_t count = 0;
+            if (bottomUp) {
+                // cells of the own word range only, no synchronization needed
+                std::fill(&next.word(from), &next.word(from) + (to - from), 0);
+                unvisited.forEachSet(from, to, [&](std::size_t idx) {
+                    for (const auto &n : terrain.neighbours(terrain.position(idx))) {
+                        const auto nIdx = terrain.index(n);
+                        if (frontier.test(nIdx) && reversed(terrain[idx], terrain[nIdx])) {
+                            distances[idx] = level + 1;
+                            unvisited.word(idx / 64) &= ~(std::uint64_t(1) << (idx % 64));
+                            next.set(idx);
+                            ++count;
+                            break;
+                        }
+                    }
+                });
+            } else {
+                const auto begin = frontierCells.size() * t / numThreads;
+                const auto end = frontierCells.size() * (t + 1) / numThreads;
+                for (auto i = begin; i < end; ++i) {
+                    const auto idx = frontierCells[i];
+                    for (const auto &n : terrain.neighbours(terrain.position(idx))) {
+                        const auto nIdx = terrain.index(n);
+                        if (unvisited.testAtomic(nIdx) && reversed(terrain[nIdx], terrain[idx]) &&
+                            unvisited.clearAtomic(nIdx)) {
+                            distances[nIdx] = level + 1;
+                            found[t].emplace_back(nIdx);
+                        }
+                    }
+                }
+
+                count = found[t].size();
+            }
+
+            nextSize += count;
+            levelDone.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads);
+    for (std::size_t t = 0; t < numThreads; ++t) {
+        workers.emplace_back(worker, t, t * chunk, std::min((t + 1) * chunk, numWords));
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    return DistanceField(std::move(distances));
+}
+
+#endif //AOC22_DAY12_PARALLELBFS_HPP
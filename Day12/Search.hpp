@@ -0,0 +1,380 @@
+#ifndef AOC22_DAY12_SEARCH_HPP
+#define AOC22_DAY12_SEARCH_HPP
+
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <concepts>
+#include <ranges>
+#include <queue>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+/**
+ * Node of the search tree. Nodes live in a pool, the parent is referenced by its index in that pool
+ */
+template <std::equality_comparable T>
+struct SearchNode {
+    static constexpr std::size_t NoParent = std::numeric_limits<std::size_t>::max();
+
+    T state;
+    std::size_t parent = NoParent;
+    unsigned pathCost = 0;
+};
+
+/**
+ * Estimate of the remaining path cost of a state. Must be integral, aStar adds it to the unsigned path costs
+ */
+template<typename H, typename T>
+concept HeuristicFunction = requires(H instance, SearchNode<T> node) {
+    {instance(node.state)} -> std::integral;
+};
+
+/**
+ * Expand function returning the successors of a state as range, e.g. a container or a fixed capacity inline range
+ */
+template<typename E, typename T>
+concept RangeExpandFunction = requires(const E &instance, const T &state) {
+    requires std::convertible_to<std::ranges::range_value_t<decltype(instance(state))>, T>;
+};
+
+/**
+ * Expand function passing each successor of a state to a callback, expand(state, fun)
+ */
+template<typename E, typename T>
+concept CallbackExpandFunction = std::invocable<const E &, const T &, void (*)(const T &)>;
+
+template<typename E, typename T>
+concept ExpandFunction = RangeExpandFunction<E, T> || CallbackExpandFunction<E, T>;
+
+/**
+ * Calls fun for each successor of state, regardless of the kind of expand function
+ */
+template<typename T, ExpandFunction<T> E, typename F>
+void forEachSuccessor(const E &expand, const T &state, F &&fun) {
+    if constexpr (CallbackExpandFunction<E, T>) {
+        expand(state, std::forward<F>(fun));
+    } else {
+        for (auto &&n : expand(state)) {
+            fun(std::forward<decltype(n)>(n));
+        }
+    }
+}
+
+template<typename G, typename T>
+concept GoalTest = requires(G instance, T state) {
+    { instance(state) } -> std::convertible_to<bool>;
+};
+
+/**
+ * Maps states to consecutive ids which address the closed set and the table of best path costs.
+ * capacity() is the number of ids known in advance (0 if unknown, tables then grow on demand)
+ */
+template<typename I, typename T>
+concept StateIndex = requires(I instance, const T &state) {
+    { instance(state) } -> std::convertible_to<std::size_t>;
+    { instance.capacity() } -> std::convertible_to<std::size_t>;
+};
+
+/**
+ * Index for states that already are small integers, e.g. cell indices of a grid
+ */
+struct DenseIndex {
+    constexpr std::size_t operator()(std::size_t state) const noexcept {
+        return state;
+    }
+
+    [[nodiscard]] constexpr std::size_t capacity() const noexcept {
+        return numStates;
+    }
+
+    std::size_t numStates;
+};
+
+/**
+ * Index for arbitrary hashable states. Ids are assigned in order of first appearance
+ */
+template<typename T, typename Hash = std::hash<T>>
+class HashIndex {
+public:
+    std::size_t operator()(const T &state) {
+        return ids.try_emplace(state, ids.size()).first->second;
+    }
+
+    [[nodiscard]] constexpr std::size_t capacity() const noexcept {
+        return 0;
+    }
+
+private:
+    std::unordered_map<T, std::size_t, Hash> ids;
+};
+
+/**
+ * Result of a successful search: the node pool and the goal node
+ */
+template<typename T>
+class SearchResult {
+public:
+    SearchResult(std::vector<SearchNode<T>> nodes, std::size_t goal) : nodes(std::move(nodes)), goal(goal) {}
+
+    [[nodiscard]] unsigned pathCost() const noexcept {
+        return nodes[goal].pathCost;
+    }
+
+    /**
+     * @return all states from start to goal
+     */
+    [[nodiscard]] auto path() const -> std::vector<T> {
+        std::vector<T> ret;
+        for (auto n = goal; n != SearchNode<T>::NoParent; n = nodes[n].parent) {
+            ret.emplace_back(nodes[n].state);
+        }
+
+        std::ranges::reverse(ret);
+        return ret;
+    }
+
+private:
+    std::vector<SearchNode<T>> nodes;
+    std::size_t goal;
+};
+
+/**
+ * Entry of the search fringe: a node from the node pool and its estimated total cost f = g + h
+ */
+struct FringeEntry {
+    unsigned f;
+    std::size_t node;
+
+    constexpr bool operator>(const FringeEntry &other) const noexcept {
+        return f > other.f;
+    }
+};
+
+/**
+ * Priority queue of fringe entries, pop() returns an entry with minimal f
+ */
+template<typename F>
+concept Fringe = requires(F instance, FringeEntry entry) {
+    instance.push(entry);
+    { instance.pop() } -> std::same_as<FringeEntry>;
+    { instance.empty() } -> std::convertible_to<bool>;
+};
+
+/**
+ * Binary heap fringe, no restrictions on the range of f
+ */
+class BinaryHeapFringe {
+public:
+    void push(const FringeEntry &entry) {
+        heap.push(entry);
+    }
+
+    FringeEntry pop() {
+        auto ret = heap.top();
+        heap.pop();
+        return ret;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return heap.empty();
+    }
+
+private:
+    std::priority_queue<FringeEntry, std::vector<FringeEntry>, std::greater<>> heap;
+};
+
+/**
+ * Bucket queue (Dial's algorithm) with one bucket per value of f. Push and pop are O(1) amortized as long as f stays
+ * within a small range, which is the case for unit edge costs and an integral consistent heuristic: popped values of f
+ * never decrease, so the cursor only moves forward. Entries with the same f are popped in LIFO order, preferring the
+ * deeper nodes
+ */
+class BucketFringe {
+public:
+    void push(const FringeEntry &entry) {
+        if (entry.f >= buckets.size()) {
+            buckets.resize(entry.f + 1);
+        }
+
+        buckets[entry.f].emplace_back(entry.node);
+        cursor = std::min<std::size_t>(cursor, entry.f);
+        ++numEntries;
+    }
+
+    FringeEntry pop() {
+        while (buckets[cursor].empty()) {
+            ++cursor;
+        }
+
+        auto node = buckets[cursor].back();
+        buckets[cursor].pop_back();
+        --numEntries;
+        return {static_cast<unsigned>(cursor), node};
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return numEntries == 0;
+    }
+
+private:
+    std::vector<std::vector<std::size_t>> buckets;
+    std::size_t cursor = 0;
+    std::size_t numEntries = 0;
+};
+
+/**
+ * A* search with unit edge costs and a non-negative integral heuristic. The closed set and the best known path cost
+ * per state are tables addressed by the state index, so checking and updating them is O(1). A node is only created
+ * (and pushed to the fringe) if it improves on the best known path cost of its state.
+ */
+template<typename T, GoalTest<T> GoalFun, ExpandFunction<T> ExpFun, HeuristicFunction<T> HFun,
+        StateIndex<T> Index = HashIndex<T>, Fringe Fr = BinaryHeapFringe>
+auto aStar(T start, const GoalFun &goalTest, const ExpFun &expand, const HFun &h, Index index = {}, Fr fringe = {})
+        -> std::optional<SearchResult<T>> {
+    constexpr auto Unknown = std::numeric_limits<unsigned>::max();
+    std::vector<SearchNode<T>> nodes;
+    std::vector<std::uint8_t> closed(index.capacity(), false);
+    std::vector<unsigned> bestCost(index.capacity(), Unknown);
+    auto lookup = [&](const T &state) {
+        std::size_t id = index(state);
+        if (id >= closed.size()) {
+            closed.resize(id + 1, false);
+            bestCost.resize(id + 1, Unknown);
+        }
+
+        return id;
+    };
+
+    nodes.push_back({std::move(start), SearchNode<T>::NoParent, 0});
+    bestCost[lookup(nodes.back().state)] = 0;
+    fringe.push({static_cast<unsigned>(h(nodes.back().state)), 0});
+    while (not fringe.empty()) {
+        const auto current = fringe.pop().node;
+        const auto id = lookup(nodes[current].state);
+        if (closed[id]) {
+            continue;
+        }
+
+        if (goalTest(nodes[current].state)) {
+            return SearchResult<T>(std::move(nodes), current);
+        }
+
+        closed[id] = true;
+        const auto g = nodes[current].pathCost + 1;
+        // copy, the pool may grow during the expansion
+        const T state = nodes[current].state;
+        forEachSuccessor(expand, state, [&](auto &&n) {
+            const auto nId = lookup(n);
+            if (closed[nId] || bestCost[nId] <= g) {
+                return;
+            }
+
+            bestCost[nId] = g;
+            nodes.push_back({std::forward<decltype(n)>(n), current, g});
+            fringe.push({g + static_cast<unsigned>(h(nodes.back().state)), nodes.size() - 1});
+        });
+    }
+
+    return {};
+}
+
+/**
+ * Bidirectional breadth first search with unit edge costs. expandForward yields the successors of a state,
+ * expandBackward its predecessors. Both searches advance one complete level at a time, always on the side with the
+ * smaller frontier. The first state reached by both sides lies on a shortest path: before the level was expanded no
+ * state was known to both sides, so no path is shorter than the sum of both depths plus one.
+ */
+template<typename T, ExpandFunction<T> FwdFun, ExpandFunction<T> BwdFun, StateIndex<T> Index = HashIndex<T>>
+auto bidirectionalSearch(T start, T goal, const FwdFun &expandForward, const BwdFun &expandBackward,
+                         Index index = {}) -> std::optional<SearchResult<T>> {
+    constexpr auto Unknown = std::numeric_limits<std::size_t>::max();
+    struct Side {
+        std::vector<SearchNode<T>> nodes;
+        std::vector<std::size_t> nodeOf;
+        std::size_t levelBegin = 0;
+
+        [[nodiscard]] std::size_t frontierSize() const noexcept {
+            return nodes.size() - levelBegin;
+        }
+    };
+
+    Side forward, backward;
+    forward.nodeOf.resize(index.capacity(), Unknown);
+    backward.nodeOf.resize(index.capacity(), Unknown);
+    auto lookup = [&](const T &state) {
+        std::size_t id = index(state);
+        if (id >= forward.nodeOf.size()) {
+            forward.nodeOf.resize(id + 1, Unknown);
+            backward.nodeOf.resize(id + 1, Unknown);
+        }
+
+        return id;
+    };
+
+    if (start == goal) {
+        return SearchResult<T>({{std::move(start), SearchNode<T>::NoParent, 0}}, 0);
+    }
+
+    forward.nodeOf[lookup(start)] = 0;
+    forward.nodes.push_back({std::move(start), SearchNode<T>::NoParent, 0});
+    backward.nodeOf[lookup(goal)] = 0;
+    backward.nodes.push_back({std::move(goal), SearchNode<T>::NoParent, 0});
+    std::size_t meetForward = Unknown, meetBackward = Unknown;
+    auto expandLevel = [&](Side &side, Side &other, const auto &expand) {
+        const auto levelEnd = side.nodes.size();
+        auto meet = std::make_pair(Unknown, Unknown);
+        for (auto current = side.levelBegin; current < levelEnd && meet.first == Unknown; ++current) {
+            const auto g = side.nodes[current].pathCost + 1;
+            const T state = side.nodes[current].state;
+            forEachSuccessor(expand, state, [&](auto &&n) {
+                const auto id = lookup(n);
+                if (meet.first != Unknown || side.nodeOf[id] != Unknown) {
+                    return;
+                }
+
+                side.nodeOf[id] = side.nodes.size();
+                side.nodes.push_back({std::forward<decltype(n)>(n), current, g});
+                if (other.nodeOf[id] != Unknown) {
+                    meet = std::make_pair(side.nodes.size() - 1, other.nodeOf[id]);
+                }
+            });
+        }
+
+        side.levelBegin = levelEnd;
+        return meet;
+    };
+
+    while (forward.frontierSize() > 0 && backward.frontierSize() > 0) {
+        if (forward.frontierSize() <= backward.frontierSize()) {
+            std::tie(meetForward, meetBackward) = expandLevel(forward, backward, expandForward);
+        } else {
+            std::tie(meetBackward, meetForward) = expandLevel(backward, forward, expandBackward);
+        }
+
+        if (meetForward != Unknown) {
+            break;
+        }
+    }
+
+    if (meetForward == Unknown) {
+        return {};
+    }
+
+    // append the backward part of the path behind the forward node pool
+    auto nodes = std::move(forward.nodes);
+    auto tail = meetForward;
+    for (auto n = backward.nodes[meetBackward].parent; n != SearchNode<T>::NoParent; n = backward.nodes[n].parent) {
+        nodes.push_back({backward.nodes[n].state, tail, nodes[tail].pathCost + 1});
+        tail = nodes.size() - 1;
+    }
+
+    return SearchResult<T>(std::move(nodes), tail);
+}
+
+#endif //AOC22_DAY12_SEARCH_HPP
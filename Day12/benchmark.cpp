@@ -0,0 +1,220 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <tuple>
+#include <cstdlib>
+#include "Field.hpp"
+#include "ParallelBfs.hpp"
+#include "Incremental.hpp"
+
+/**
+ * Generates a solvable-looking heightmap: a ramp from 'a' at the top left to 'z' at the bottom right that rises by at
+ * most one per step, where a fraction of the cells is raised by two to form walls
+ */
+auto generateHeightmap(std::size_t width, std::size_t height, double wallRatio, unsigned seed) -> std::string {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution isWall(wallRatio);
+    std::string ret;
+    ret.reserve((width + 1) * height);
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            auto level = std::min<std::size_t>(25, (x + y) * 26 / (width + height));
+            if (isWall(rng)) {
+                level = std::min<std::size_t>(25, level + 2);
+            }
+
+            ret += static_cast<char>('a' + level);
+        }
+
+        ret += '\n';
+    }
+
+    ret.front() = 'S';
+    ret[(width + 1) * height - 2] = 'E';
+    return ret;
+}
+
+template<typename F>
+auto timed(F &&fun) {
+    auto start = std::chrono::steady_clock::now();
+    auto res = fun();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return std::make_pair(res, elapsed.count());
+}
+
+/**
+ * Runs the query with the binary heap and the bucket fringe and prints both timings
+ * @param expected path cost according to the distance field
+ * @return true if both fringes yield the expected path cost
+ */
+template<typename Query>
+bool compare(const std::string &name, unsigned expected, Query &&query) {
+    auto [heapRes, heapTime] = timed([&] { return query(BinaryHeapFringe{}); });
+    auto [bucketRes, bucketTime] = timed([&] { return query(BucketFringe{}); });
+    std::cout << name << ": " << heapRes << std::endl
+              << "\tbinary heap fringe: " << heapTime << " ms" << std::endl
+              << "\tbucket fringe: " << bucketTime << " ms" << std::endl;
+    if (heapRes != expected || bucketRes != expected) {
+        std::cerr << "results differ: " << heapRes << " vs " << bucketRes << " vs " << expected << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Answers point to point queries between random cells with unidirectional A* and with bidirectional search
+ * @return true if both always yield the same path cost
+ */
+template<ElevationConstraint C>
+bool comparePointToPoint(const Field &field, const C &constraint, unsigned seed) {
+    constexpr std::size_t NumQueries = 20;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> randomX(0, field.terrain.width() - 1);
+    std::uniform_int_distribution<std::size_t> randomY(0, field.terrain.height() - 1);
+    double unidirectionalTime = 0, bidirectionalTime = 0;
+    std::size_t numReachable = 0;
+    for (std::size_t q = 0; q < NumQueries; ++q) {
+        const auto start = field.terrain.index(randomX(rng), randomY(rng));
+        const auto goal = field.terrain.index(randomX(rng), randomY(rng));
+        auto [unidirectional, uTime] = timed([&] {
+            auto res = aStar(start, [goal](auto idx) { return idx == goal; }, expandUnder(field, constraint),
+                             [&field, goal](auto idx) { return field.dist(idx, goal); },
+                             DenseIndex{field.terrain.storageSize()}, BucketFringe{});
+            return res.has_value() ? std::optional(res->pathCost()) : std::nullopt;
+        });
+
+        auto [bidirectional, bTime] = timed([&] { return bidirectionalShortestPath(field, start, goal, constraint); });
+        unidirectionalTime += uTime;
+        bidirectionalTime += bTime;
+        numReachable += unidirectional.has_value();
+        if (unidirectional != bidirectional) {
+            std::cerr << "point to point query " << q << " differs" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << NumQueries << " random point to point queries, " << numReachable << " reachable" << std::endl
+              << "\tunidirectional A*: " << unidirectionalTime << " ms" << std::endl
+              << "\tbidirectional search: " << bidirectionalTime << " ms" << std::endl;
+    return true;
+}
+
+/**
+ * Applies batches of random height changes to a copy of the field and compares the repair of an incremental search to
+ * a new A* search after each batch
+ * @return true if both searches always yield the same path cost
+ */
+template<ElevationConstraint C>
+bool compareReplanning(const Field &original, const C &constraint, unsigned seed) {
+    constexpr std::size_t NumBatches = 50;
+    constexpr std::size_t BatchSize = 4;
+    Field field = original;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> randomX(0, field.terrain.width() - 1);
+    std::uniform_int_distribution<std::size_t> randomY(0, field.terrain.height() - 1);
+    std::uniform_int_distribution<int> randomHeight(0, 'z' - 'a');
+    IncrementalSearch incremental(field, field.start, field.goal, constraint);
+    auto goalTest = [&field](auto idx) { return idx == field.goal; };
+    auto h = [&field](auto idx) { return field.dist(idx, field.goal); };
+    auto [initial, initialTime] = timed([&] { return incremental.pathCost(); });
+    double incrementalTime = 0, scratchTime = 0;
+    for (std::size_t batch = 0; batch < NumBatches; ++batch) {
+        std::vector<TerrainUpdate> changes;
+        for (std::size_t i = 0; i < BatchSize; ++i) {
+            changes.push_back({field.terrain.index(randomX(rng), randomY(rng)), randomHeight(rng)});
+        }
+
+        auto [repaired, repairTime] = timed([&] {
+            incremental.update(changes);
+            return incremental.pathCost();
+        });
+
+        incrementalTime += repairTime;
+        // A* cannot report unreachable goals, the distance field serves as reference for those
+        auto expected = DistanceField::toTarget(field, field.goal, constraint)[field.start];
+        if (expected != DistanceField::Unreachable) {
+            double time;
+            std::tie(expected, time) = timed(
+                    [&] { return shortestPath(field.start, field, goalTest, constraint, h, BucketFringe{}); });
+            scratchTime += time;
+        }
+
+        if (repaired != expected) {
+            std::cerr << "replanning differs after batch " << batch << ": " << repaired << " vs " << expected
+                      << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "replanning after " << NumBatches << " batches of " << BatchSize << " changes, initial cost "
+              << initial << std::endl
+              << "\tinitial incremental search: " << initialTime << " ms" << std::endl
+              << "\tincremental repairs: " << incrementalTime << " ms" << std::endl
+              << "\tA* from scratch: " << scratchTime << " ms" << std::endl;
+    return true;
+}
+
+/**
+ * usage: benchmark [width] [height] [wall ratio] [seed]
+ */
+int main(int argc, char **argv) {
+    const std::size_t width = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    const std::size_t height = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    const double wallRatio = argc > 3 ? std::strtod(argv[3], nullptr) : 0.3;
+    const unsigned seed = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1;
+    std::istringstream in(generateHeightmap(width, height, wallRatio, seed));
+    const Field field(in);
+    std::cout << "heightmap " << width << "x" << height << ", wall ratio " << wallRatio << std::endl;
+    auto goalTest = [&field](auto idx) { return idx == field.goal; };
+    const Climb climb;
+    const auto masksTime = timed([&field] {
+        return std::pair(&field.masks<Climb>(), &field.masks<Reversed<Climb>>());
+    }).second;
+
+    std::cout << "passability masks (cached for all queries): " << masksTime << " ms" << std::endl;
+    auto [sequential, sequentialTime] = timed([&] { return DistanceField::toTarget(field, field.goal, climb); });
+    auto [parallel, parallelTime] = timed([&] { return parallelDistanceField(field, field.goal, climb); });
+    std::cout << "distance field to goal: " << sequential[field.start] << std::endl
+              << "\tsequential: " << sequentialTime << " ms" << std::endl
+              << "\tparallel frontier: " << parallelTime << " ms" << std::endl;
+    bool consistent = sequential == parallel;
+    if (not consistent) {
+        std::cerr << "distance fields differ" << std::endl;
+    }
+
+    const auto fromStart = sequential[field.start];
+    if (bidirectionalShortestPath(field, field.start, field.goal, climb).value_or(DistanceField::Unreachable) !=
+        fromStart) {
+        std::cerr << "bidirectional search from start to goal differs from the distance field" << std::endl;
+        consistent = false;
+    }
+
+    // shortestPath exits on unsolvable queries, so only run the ones the distance field deems solvable
+    auto h = [&field](auto idx) { return field.dist(idx, field.goal); };
+    if (fromStart != DistanceField::Unreachable) {
+        consistent &= compare("start to goal, manhattan heuristic", fromStart, [&](auto fringe) {
+            return shortestPath(field.start, field, goalTest, climb, h, fringe);
+        });
+    } else {
+        std::cout << "start to goal: unreachable" << std::endl;
+    }
+
+    auto lowest = [&field](auto idx) { return field.terrain[idx] == 0; };
+    const Reversed<Climb> descend{climb};
+    const auto fromAnyA = sequential.nearest(field.startingPoints);
+    if (fromAnyA != DistanceField::Unreachable) {
+        consistent &= compare("goal to any 'a', no heuristic", fromAnyA, [&](auto fringe) {
+            return shortestPath(field.goal, field, lowest, descend, [](auto) { return 0; }, fringe);
+        });
+    } else {
+        std::cout << "goal to any 'a': unreachable" << std::endl;
+    }
+
+    consistent &= comparePointToPoint(field, climb, seed);
+    consistent &= compareReplanning(field, climb, seed);
+    return consistent ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+#ifndef AOC22_DAY13_PACKETS_HPP
+#define AOC22_DAY13_PACKETS_HPP
+
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <vector>
+#include <span>
+#include <compare>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <ranges>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+using LitType = int;
+
+/**
+ * Packets are stored as flat token streams: list brackets are encoded by two reserved values, all other values are
+ * literals
+ */
+namespace token {
+    constexpr LitType Open = std::numeric_limits<LitType>::min();
+    constexpr LitType Close = Open + 1;
+
+    constexpr bool isLiteral(LitType token) noexcept {
+        return token != Open && token != Close;
+    }
+}
+
+using Packet = std::span<const LitType>;
+
+/**
+ * Parses a packet and appends its tokens to out. The packet must be a single list, nothing may follow its closing
+ * bracket
+ */
+inline void tokenize(std::string_view line, std::vector<LitType> &out) {
+    int depth = 0;
+    for (auto curr = line.begin(); curr != line.end();) {
+        if (depth == 0 && curr != line.begin()) {
+            throw std::runtime_error("trailing tokens after packet '" + std::string(line) + "'");
+        }
+
+        if (*curr == '[') {
+            out.emplace_back(token::Open);
+            ++depth;
+            ++curr;
+        } else if (*curr == ']') {
+            out.emplace_back(token::Close);
+            --depth;
+            ++curr;
+        } else if (*curr == ',') {
+            ++curr;
+        } else {
+            LitType value;
+            auto [next, ec] = std::from_chars(&*curr, line.data() + line.size(), value);
+            if (ec != std::errc{} || not token::isLiteral(value)) {
+                throw std::runtime_error("invalid literal in packet '" + std::string(line) + "'");
+            }
+
+            out.emplace_back(value);
+            curr += next - &*curr;
+        }
+
+        if (depth < 0) {
+            throw std::runtime_error("unbalanced brackets in packet '" + std::string(line) + "'");
+        }
+    }
+
+    if (depth != 0 || line.empty() || line.front() != '[') {
+        throw std::runtime_error("packet '" + std::string(line) + "' is not a list");
+    }
+}
+
+/**
+ * All packets back to back in a single token buffer
+ */
+class PacketBuffer {
+public:
+    /**
+     * @return index of the added packet
+     */
+    std::size_t add(std::string_view line) {
+        tokenize(line, tokens);
+        offsets.emplace_back(tokens.size());
+        return offsets.size() - 2;
+    }
+
+    Packet operator[](std::size_t idx) const noexcept {
+        return Packet(tokens).subspan(offsets[idx], offsets[idx + 1] - offsets[idx]);
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return offsets.size() - 1;
+    }
+
+    /**
+     * Removes all packets, keeps the allocated memory
+     */
+    void clear() noexcept {
+        tokens.clear();
+        offsets.resize(1);
+    }
+
+private:
+    std::vector<LitType> tokens;
+    std::vector<std::size_t> offsets{0};
+};
+
+/**
+ * Compares two packets by walking both token streams side by side. A literal compared against a list is promoted to
+ * a singleton list on the fly: for each list opened on the other side, one closing bracket is owed behind the literal
+ */
+inline std::strong_ordering compare(Packet lhs, Packet rhs) noexcept {
+    std::size_t l = 0, r = 0;
+    // closing brackets of promoted literals: owed after the literal is consumed (wrap), still to be consumed (pending)
+    std::size_t wrapL = 0, wrapR = 0, pendingL = 0, pendingR = 0;
+    while (true) {
+        const auto tl = pendingL > 0 ? token::Close : lhs[l];
+        const auto tr = pendingR > 0 ? token::Close : rhs[r];
+        if (tl == token::Close || tr == token::Close) {
+            if (tl != tr) {
+                return tl == token::Close ? std::strong_ordering::less : std::strong_ordering::greater;
+            }
+
+            if (pendingL > 0) {
+                --pendingL;
+            } else {
+                ++l;
+            }
+
+            if (pendingR > 0) {
+                --pendingR;
+            } else {
+                ++r;
+            }
+
+            if (l == lhs.size() && r == rhs.size()) {
+                return std::strong_ordering::equal;
+            }
+        } else if (tl == token::Open && tr == token::Open) {
+            ++l;
+            ++r;
+        } else if (tl == token::Open) {
+            ++l;
+            ++wrapR;
+        } else if (tr == token::Open) {
+            ++r;
+            ++wrapL;
+        } else {
+            if (tl != tr) {
+                return tl <=> tr;
+            }
+
+            ++l;
+            ++r;
+            pendingL = std::exchange(wrapL, 0);
+            pendingR = std::exchange(wrapR, 0);
+        }
+    }
+}
+
+/**
+ * Fixed length prefix key of a packet: if key(a) < key(b) then a < b, equal keys decide nothing. The key encodes the
+ * leading events of the comparison walk, 16 bits each:
+ * - the first token that is no opening bracket: a closing bracket (code 1 + number of skipped opening brackets) or a
+ *   literal (code LiteralBase + 1 + value), any closing bracket is smaller than any literal
+ * - after a literal, the nesting depth remaining after the closing brackets that follow it. Literals promoted to lists
+ *   owe closing brackets, so a smaller remaining depth means that the packet ends more lists, i.e. is smaller.
+ *   Afterwards both packets continue at the same depth
+ * The key ends (zero padded) after a closing bracket event, at the end of the packet or if a value exceeds its field.
+ * Since these conditions only depend on the encoded values, packets with equal keys always end their keys together
+ */
+[[nodiscard]] inline std::uint64_t prefixKey(Packet packet) noexcept {
+    constexpr unsigned EventBits = 12;
+    constexpr unsigned DepthBits = 4;
+    constexpr std::uint64_t MaxOpens = 14;
+    constexpr std::uint64_t LiteralBase = MaxOpens + 3;
+    constexpr std::uint64_t MaxEvent = (std::uint64_t(1) << EventBits) - 1;
+    constexpr std::uint64_t MaxDepth = (std::uint64_t(1) << DepthBits) - 1;
+    std::uint64_t key = 0;
+    unsigned shift = 64;
+    auto emit = [&key, &shift](std::uint64_t value, unsigned bits) {
+        shift -= bits;
+        key |= value << shift;
+    };
+
+    std::size_t pos = 0;
+    std::uint64_t depth = 0;
+    while (shift >= EventBits + DepthBits) {
+        std::uint64_t opens = 0;
+        for (; packet[pos] == token::Open; ++pos) {
+            ++opens;
+        }
+
+        depth += opens;
+        if (packet[pos] == token::Close) {
+            emit(1 + std::min(opens, MaxOpens + 1), EventBits);
+            break;
+        }
+
+        const auto value = packet[pos++];
+        const auto code = value < 0 ? LiteralBase : LiteralBase + 1 + std::min<std::uint64_t>(
+                static_cast<std::uint64_t>(value), MaxEvent - LiteralBase - 1);
+        emit(code, EventBits);
+        if (code == LiteralBase || code == MaxEvent) {
+            break;
+        }
+
+        for (; pos < packet.size() && packet[pos] == token::Close; ++pos) {
+            --depth;
+        }
+
+        emit(std::min(depth, MaxDepth), DepthBits);
+        if (depth == 0 || depth >= MaxDepth) {
+            break;
+        }
+    }
+
+    return key;
+}
+
+/**
+ * Calls fun(i) for i in [0, count), each on its own thread
+ */
+template<typename F>
+void forEachParallel(std::size_t count, const F &fun) {
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        workers.emplace_back(fun, i);
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+
+/**
+ * Sorts all packets of the buffer: (prefix key, index) pairs are sorted in chunks on separate threads and merged
+ * pairwise in parallel rounds. Packets are only compared structurally if their keys are equal
+ * @return packet indices in ascending packet order
+ */
+inline auto sortedOrder(const PacketBuffer &packets, std::size_t numThreads = std::thread::hardware_concurrency())
+        -> std::vector<std::size_t> {
+    struct Entry {
+        std::uint64_t key;
+        std::size_t idx;
+    };
+
+    const auto n = packets.size();
+    const std::size_t numChunks = std::clamp<std::size_t>(numThreads, 1, std::max<std::size_t>(n, 1));
+    std::vector<std::size_t> bounds(numChunks + 1);
+    for (std::size_t c = 0; c <= numChunks; ++c) {
+        bounds[c] = n * c / numChunks;
+    }
+
+    std::vector<Entry> entries(n);
+    auto less = [&packets](const Entry &a, const Entry &b) {
+        return a.key != b.key ? a.key < b.key : compare(packets[a.idx], packets[b.idx]) < 0;
+    };
+
+    forEachParallel(numChunks, [&](std::size_t c) {
+        for (auto i = bounds[c]; i < bounds[c + 1]; ++i) {
+            entries[i] = {prefixKey(packets[i]), i};
+        }
+
+        std::sort(entries.begin() + bounds[c], entries.begin() + bounds[c + 1], less);
+    });
+
+    for (std::size_t width = 1; width < numChunks; width *= 2) {
+        forEachParallel((numChunks + 2 * width - 1) / (2 * width), [&](std::size_t m) {
+            const auto first = 2 * width * m;
+            if (first + width < numChunks) {
+                std::inplace_merge(entries.begin() + bounds[first], entries.begin() + bounds[first + width],
+                                   entries.begin() + bounds[std::min(first + 2 * width, numChunks)], less);
+            }
+        });
+    }
+
+    std::vector<std::size_t> ret;
+    ret.reserve(n);
+    for (const auto &e : entries) {
+        ret.emplace_back(e.idx);
+    }
+
+    return ret;
+}
+
+/**
+ * Ranks divider packets among a stream of packets without storing or sorting them. The (1-based) position of a divider
+ * in the sorted list of all packets and dividers is one plus the number of packets and other dividers that are
+ * strictly smaller, which is also the position of the first packet equal to the divider
+ */
+class DividerRanking {
+public:
+    template<std::ranges::input_range R>
+    explicit DividerRanking(R &&dividerPackets) {
+        for (const auto &d : dividerPackets) {
+            dividers.add(d);
+        }
+
+        lessCount.resize(dividers.size());
+        for (std::size_t i = 0; i < dividers.size(); ++i) {
+            for (std::size_t j = 0; j < dividers.size(); ++j) {
+                lessCount[i] += compare(dividers[j], dividers[i]) < 0;
+            }
+        }
+    }
+
+    void add(Packet packet) noexcept {
+        for (std::size_t i = 0; i < dividers.size(); ++i) {
+            lessCount[i] += compare(packet, dividers[i]) < 0;
+        }
+    }
+
+    /**
+     * @return 1-based position of the divider among all packets added so far and all dividers
+     */
+    [[nodiscard]] std::size_t position(std::size_t divider) const noexcept {
+        return lessCount[divider] + 1;
+    }
+
+    [[nodiscard]] std::size_t numDividers() const noexcept {
+        return dividers.size();
+    }
+
+private:
+    PacketBuffer dividers;
+    std::vector<std::size_t> lessCount;
+};
+
+inline void print(Packet packet, bool end = true) {
+    bool first = true;
+    for (auto t : packet) {
+        if (t != token::Close && not first) {
+            std::cout << ", ";
+        }
+
+        first = t == token::Open;
+        if (t == token::Open) {
+            std::cout << "[";
+        } else if (t == token::Close) {
+            std::cout << "]";
+        } else {
+            std::cout << t;
+        }
+    }
+
+    if (end) {
+        std::cout << std::endl;
+    }
+}
+
+#endif //AOC22_DAY13_PACKETS_HPP
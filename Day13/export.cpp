@@ -0,0 +1,45 @@
+#include <string>
+#include <iostream>
+#include <array>
+#include "../util/util.hpp"
+#include "Packets.hpp"
+
+/**
+ * Prints all packets including the dividers in ascending order
+ */
+int main(int argc, char **argv) {
+    auto file = util::getInputFile(argc, argv);
+    constexpr std::array dividers{"[[2]]", "[[6]]"};
+    PacketBuffer packets;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (not line.empty()) {
+            packets.add(line);
+        }
+    }
+
+    DividerRanking ranking(dividers);
+    for (std::size_t i = 0; i < packets.size(); ++i) {
+        ranking.add(packets[i]);
+    }
+
+    const auto firstDivider = packets.size();
+    for (const auto *d : dividers) {
+        packets.add(d);
+    }
+
+    const auto order = sortedOrder(packets);
+    for (auto idx : order) {
+        print(packets[idx]);
+    }
+
+    // the first packet equal to a divider is at its rank
+    for (std::size_t d = 0; d < dividers.size(); ++d) {
+        auto pos = ranking.position(d) - 1;
+        if (pos >= order.size() || compare(packets[order[pos]], packets[firstDivider + d]) != 0 ||
+            (pos > 0 && compare(packets[order[pos - 1]], packets[firstDivider + d]) >= 0)) {
+            std::cerr << "sorted order is inconsistent with the rank of divider " << dividers[d] << std::endl;
+            return 1;
+        }
+    }
+}
@@ -10,6 +10,7 @@
 #include <Iterators.hpp>
 #include <fmt/core.h>
 #include "../util/util.hpp"
+#include "../util/Grid.hpp"
 
 constexpr int sgn(int x) noexcept {
     if (x == 0) {
@@ -81,10 +82,11 @@ struct Field {
     static constexpr auto Free = 0;
     static constexpr auto Sand = 1;
     static constexpr auto Blocked = 2;
+    static constexpr auto Abyss = 3;
     static constexpr Vec SandSource{500, 0};
 
     explicit Field(const std::vector<Path> &paths, int minX, int maxX, int maxY) :
-            minX(minX), stride(maxX - minX + 1), field(stride * (maxY + 1), Free) {
+            minX(minX), field(maxX - minX + 1, maxY + 1, Free, 1, Abyss) {
         for (const auto &path : paths) {
             for (auto [from, to] : iterators::zip(path.vertices, path.vertices | std::views::drop(1))) {
                 auto dir = (to - from).toDirVec();
@@ -100,48 +102,34 @@ struct Field {
     }
 
     const int &operator()(const Vec &pos) const noexcept {
-        return field[vecToIdx(pos)];
+        return field(toGridPos(pos));
     }
 
     int &operator()(const Vec &pos) noexcept {
-        return field[vecToIdx(pos)];
-    }
-
-    [[nodiscard]] constexpr Vec idxToVec(std::size_t idx) const noexcept{
-        return {static_cast<int>(idx % stride), static_cast<int>(idx / stride)};
+        return field(toGridPos(pos));
     }
 
+    /**
+     * The field is surrounded by a border of Abyss cells, so direct neighbours of any cell inside the field can be
+     * accessed without bounds checks
+     */
     [[nodiscard]] auto percolate(const Vec &sandPos) const noexcept -> std::optional<Vec> {
-        if (not contains(sandPos + Vec(0, 1))) {
-            return {};
-        }
-
-        if (free(sandPos + Vec(0, 1))) {
-            return sandPos + Vec(0, 1);
-        }
-
-        if (not contains(sandPos + Vec(-1, 1))) {
-            return {};
-        }
-
-        if (free(sandPos + Vec(-1, 1))) {
-            return sandPos + Vec(-1, 1);
-        }
-
-        if (not contains(sandPos + Vec(1, 1))) {
-            return {};
-        }
+        for (auto dir : {Vec(0, 1), Vec(-1, 1), Vec(1, 1)}) {
+            const auto next = sandPos + dir;
+            if ((*this)(next) == Abyss) {
+                return {};
+            }
 
-        if (free(sandPos + Vec(1, 1))) {
-            return sandPos + Vec(1, 1);
+            if (free(next)) {
+                return next;
+            }
         }
 
-
         return sandPos;
     }
 
     [[nodiscard]] bool contains(const Vec &pos) const noexcept {
-        return vecToIdx(pos) < field.size();
+        return field.contains(toGridPos(pos));
     }
 
     [[nodiscard]] bool free(const Vec &pos) const noexcept {
@@ -153,28 +141,15 @@ struct Field {
     }
 
     void print() const {
-        for (auto [idx, val] : iterators::enumerate(field)) {
-            if (idx == vecToIdx(SandSource)) {
-                std::cout << "+";
-                continue;
-            }
-
-            if (idx % stride == 0) {
-                std::cout << std::endl;
-            }
+        for (util::GridPos::Coord y = 0; y < static_cast<util::GridPos::Coord>(field.height()); ++y) {
+            std::cout << std::endl;
+            for (auto [x, val] : iterators::enumerate(field.row(y))) {
+                if (util::GridPos(x, y) == toGridPos(SandSource)) {
+                    std::cout << "+";
+                    continue;
+                }
 
-            switch (val) {
-                case Free:
-                    std::cout << ".";
-                    break;
-                case Sand:
-                    std::cout << "o";
-                    break;
-                case Blocked:
-                    std::cout << "#";
-                    break;
-                default:
-                    throw std::runtime_error("invalid field value");
+                printCell(val);
             }
         }
 
@@ -182,13 +157,28 @@ struct Field {
     }
 
 private:
-    [[nodiscard]] constexpr std::size_t vecToIdx(const Vec &pos) const noexcept {
-        return pos.y * stride + pos.x - minX;
+    static void printCell(int val) {
+        switch (val) {
+            case Free:
+                std::cout << ".";
+                break;
+            case Sand:
+                std::cout << "o";
+                break;
+            case Blocked:
+                std::cout << "#";
+                break;
+            default:
+                throw std::runtime_error("invalid field value");
+        }
+    }
+
+    [[nodiscard]] constexpr util::GridPos toGridPos(const Vec &pos) const noexcept {
+        return {pos.x - minX, pos.y};
     }
 
     int minX;
-    std::size_t stride;
-    std::vector<int> field;
+    util::Grid<int> field;
 };
 
 void runSimulation(Field &field) {
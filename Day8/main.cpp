@@ -1,62 +1,111 @@
 #include <string>
 #include <iostream>
-#include <cassert>
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <cstdint>
 #include "../util/util.hpp"
+#include "../util/Grid.hpp"
 
-using tree_array = std::vector<int>;
-using visited_array = std::vector<bool>;
+using tree_grid = util::Grid<std::uint8_t>;
+using visibility_mask = util::Grid<std::uint8_t>;
 
-constexpr std::size_t index(std::size_t row, std::size_t col, size_t stride) noexcept {
-    return stride * row + col;
-}
+constexpr std::size_t TransposeBlock = 64;
 
-std::size_t visibleInLine(const tree_array &trees, visited_array &alreadyCounted,
-                          std::size_t nCols, std::size_t idx, bool row) {
-    assert(trees.size() == alreadyCounted.size());
-    const std::size_t nRows = trees.size() / nCols;
-    const std::size_t maxIdx = row ? nCols : nRows;
-    int maxLeft = -1, maxRight = -1;
-    std::size_t ret = 0;
-    auto check = [&ret, &trees, &alreadyCounted](auto tidx, auto &max) {
-        if (not alreadyCounted[tidx] and trees[tidx] > max) {
-            alreadyCounted[tidx] = true;
-            ++ret;
-        }
+template<typename F>
+void parallelFor(std::size_t begin, std::size_t end, const F &fun) {
+    if (begin >= end) {
+        return;
+    }
 
-        max = std::max(max, trees[tidx]);
-    };
-    for (std::size_t i = 0; i < maxIdx; ++i) {
-        const auto inverse = maxIdx - 1 - i;
-        const auto leftIdx = index(row ? idx : i, row ? i : idx, nCols);
-        const auto rightIdx = index(row ? idx : inverse, row ? inverse : idx, nCols);
-        check(leftIdx, maxLeft);
-        check(rightIdx, maxRight);
+    const std::size_t numThreads = std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, end - begin);
+    const std::size_t chunk = (end - begin + numThreads - 1) / numThreads;
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads);
+    for (std::size_t from = begin; from < end; from += chunk) {
+        workers.emplace_back(fun, from, std::min(from + chunk, end));
     }
 
-    return ret;
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+
+/**
+ * Transposes a nRows x nCols row-major matrix block by block so that both reads and writes stay within a few cache
+ * lines. If Merge is set, the transposed values are or-ed into the destination instead of overwriting it
+ */
+template<bool Merge = false>
+void transpose(const std::uint8_t *src, std::uint8_t *dst, std::size_t nRows, std::size_t nCols) {
+    parallelFor(0, (nRows + TransposeBlock - 1) / TransposeBlock, [=](std::size_t from, std::size_t to) {
+        for (std::size_t rb = from * TransposeBlock; rb < std::min(to * TransposeBlock, nRows); rb += TransposeBlock) {
+            for (std::size_t cb = 0; cb < nCols; cb += TransposeBlock) {
+                for (std::size_t r = rb; r < std::min(rb + TransposeBlock, nRows); ++r) {
+                    for (std::size_t c = cb; c < std::min(cb + TransposeBlock, nCols); ++c) {
+                        if constexpr (Merge) {
+                            dst[c * nRows + r] |= src[r * nCols + c];
+                        } else {
+                            dst[c * nRows + r] = src[r * nCols + c];
+                        }
+                    }
+                }
+            }
+        }
+    });
 }
 
-constexpr std::array<std::size_t, 4> sentinel(std::size_t index, std::size_t nCol, std::size_t nRow) noexcept {
-    std::size_t row = index / nCol;
-    std::size_t col = index % nCol;
-    return {(row + 1) * nCol - 1, col, row * nCol, (nRow - 1) * nCol + col};
+/**
+ * Marks all trees visible from the first or the last line of a row-major grid. Lanes [from, to) are processed side by
+ * side with a running maximum per lane, so the inner loops are contiguous and vectorize
+ */
+void sweepLanes(const std::uint8_t *trees, std::uint8_t *visible, std::size_t nLines, std::size_t stride,
+                std::size_t from, std::size_t to) {
+    const std::size_t width = to - from;
+    std::vector<std::uint8_t> maxFront(trees + from, trees + to);
+    std::vector<std::uint8_t> maxBack(trees + (nLines - 1) * stride + from, trees + (nLines - 1) * stride + to);
+    std::fill_n(visible + from, width, 1);
+    std::fill_n(visible + (nLines - 1) * stride + from, width, 1);
+    for (std::size_t line = 1; line < nLines; ++line) {
+        const auto *front = trees + line * stride + from;
+        const auto *back = trees + (nLines - 1 - line) * stride + from;
+        auto *visFront = visible + line * stride + from;
+        auto *visBack = visible + (nLines - 1 - line) * stride + from;
+        for (std::size_t i = 0; i < width; ++i) {
+            visFront[i] |= front[i] > maxFront[i];
+            maxFront[i] = std::max(maxFront[i], front[i]);
+            visBack[i] |= back[i] > maxBack[i];
+            maxBack[i] = std::max(maxBack[i], back[i]);
+        }
+    }
 }
 
-constexpr std::array<int, 4> increment(std::size_t nCol) noexcept {
-    return {1, -static_cast<int>(nCol), -1, static_cast<int>(nCol)};
+std::size_t countVisible(const tree_grid &trees) {
+    const std::size_t nRows = trees.height();
+    const std::size_t nCols = trees.width();
+    visibility_mask visible(nCols, nRows, 0);
+    parallelFor(0, nCols, [&](std::size_t from, std::size_t to) {
+        sweepLanes(trees.data(), visible.data(), nRows, nCols, from, to);
+    });
+
+    tree_grid transposed(nRows, nCols);
+    visibility_mask visibleTransposed(nRows, nCols, 0);
+    transpose(trees.data(), transposed.data(), nRows, nCols);
+    parallelFor(0, nRows, [&](std::size_t from, std::size_t to) {
+        sweepLanes(transposed.data(), visibleTransposed.data(), nCols, nRows, from, to);
+    });
+
+    transpose<true>(visibleTransposed.data(), visible.data(), nCols, nRows);
+    return std::reduce(visible.data(), visible.data() + visible.storageSize(), std::size_t(0));
 }
 
-unsigned distance(const tree_array &trees, std::size_t index, std::size_t numCols, unsigned dir) noexcept {
-    auto sen = sentinel(index, numCols, trees.size() / numCols)[dir];
-    int inc = increment(numCols)[dir];
-    int treeSize = trees[index];
+unsigned distance(const tree_grid &trees, util::GridPos pos, const util::GridPos &dir) noexcept {
+    const auto treeSize = trees(pos);
     unsigned ret = 0;
-    while (index != sen) {
-        index += inc;
+    for (pos = pos + dir; trees.contains(pos); pos = pos + dir) {
         ++ret;
-        if (trees[index] >= treeSize) {
+        if (trees(pos) >= treeSize) {
             break;
         }
     }
@@ -64,10 +113,10 @@ unsigned distance(const tree_array &trees, std::size_t index, std::size_t numCol
     return ret;
 }
 
-unsigned scenicScore(const tree_array &trees, std::size_t index, std::size_t numCols) noexcept {
+unsigned scenicScore(const tree_grid &trees, const util::GridPos &pos) noexcept {
     unsigned ret = 1;
-    for (unsigned dir = 0; dir < 4; ++dir) {
-        ret *= distance(trees, index, numCols, dir);
+    for (const auto &dir : tree_grid::Directions) {
+        ret *= distance(trees, pos, dir);
     }
 
     return ret;
@@ -77,33 +126,23 @@ unsigned scenicScore(const tree_array &trees, std::size_t index, std::size_t num
 int main(int argc, char **argv) {
     auto file = util::getInputFile(argc, argv);
     std::string line;
-    tree_array trees;
-    std::size_t numCols = 0;
+    std::vector<std::string> lines;
     while (std::getline(file, line)) {
-        if (numCols == 0) {
-            numCols = line.size();
-        }
-
-        for (char c : line) {
-            trees.emplace_back(c - '0');
-        }
-    }
-
-    visited_array visible(trees.size(), false);
-    const std::size_t numRows = trees.size() / numCols;
-    std::size_t numVisible = 0;
-    for (std::size_t row = 0; row < numRows; ++row) {
-        numVisible += visibleInLine(trees, visible, numCols, row, true);
+        lines.emplace_back(std::move(line));
     }
 
-    for (std::size_t col = 0; col < numCols; ++col ) {
-        numVisible += visibleInLine(trees, visible, numCols, col, false);
+    tree_grid trees(lines.front().size(), lines.size());
+    for (std::size_t row = 0; row < lines.size(); ++row) {
+        std::ranges::transform(lines[row], trees.row(row).begin(), [](char c) { return c - '0'; });
     }
 
+    const std::size_t numVisible = countVisible(trees);
     std::cout << "num visible trees " << numVisible << std::endl;
     unsigned best = 0;
-    for (std::size_t index = 0; index < trees.size(); ++index) {
-        best = std::max(best, scenicScore(trees, index, numCols));
+    for (util::GridPos::Coord y = 0; y < static_cast<util::GridPos::Coord>(trees.height()); ++y) {
+        for (util::GridPos::Coord x = 0; x < static_cast<util::GridPos::Coord>(trees.width()); ++x) {
+            best = std::max(best, scenicScore(trees, {x, y}));
+        }
     }
 
     std::cout << "best scenic score " << best << std::endl;
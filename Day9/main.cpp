@@ -1,11 +1,16 @@
 #include <string>
 #include <iostream>
 #include <cassert>
-#include <unordered_set>
 #include <concepts>
-#include <Iterators.hpp>
 #include <ranges>
+#include <algorithm>
+#include <tuple>
+#include <array>
+#include <utility>
+#include <stdexcept>
+#include <cstdlib>
 #include "../util/util.hpp"
+#include "../util/PositionSet.hpp"
 
 
 struct Pos {
@@ -13,10 +18,6 @@ struct Pos {
 
     constexpr Pos() noexcept : Pos(0, 0) {}
 
-    [[nodiscard]] std::string toString() const {
-        return std::to_string(x) + "," + std::to_string(y);
-    }
-
     [[nodiscard]] constexpr int manhattanDist(const Pos &other) const noexcept {
         return std::abs(x - other.x) + std::abs(y - other.y);
     }
@@ -29,10 +30,16 @@ struct Pos {
         return {x - other.x, y - other.y};
     }
 
+    constexpr Pos operator*(std::integral auto factor) const noexcept {
+        return {static_cast<int>(x * factor), static_cast<int>(y * factor)};
+    }
+
     constexpr Pos operator/(std::integral auto factor) const noexcept {
         return {x / factor, y / factor};
     }
 
+    constexpr bool operator==(const Pos &other) const noexcept = default;
+
     int x, y;
 };
 
@@ -62,32 +69,324 @@ constexpr Pos moveHead(const Pos &head, char dir) noexcept {
     }
 }
 
+struct Motion {
+    char dir;
+    unsigned steps;
+};
+
+template<std::size_t ...Tracked>
+using VisitedCounts = std::array<std::size_t, sizeof...(Tracked)>;
+
+template<std::size_t N, std::size_t ...Tracked>
+concept RopeConfig = N >= 2 && ((Tracked < N) && ...);
+
+/**
+ * Moves every knot after the head towards its predecessor, unrolled over the whole rope
+ */
+template<std::size_t N>
+constexpr void pullRope(std::array<Pos, N> &rope) noexcept {
+    [&rope]<std::size_t ...I>(std::index_sequence<I...>) {
+        ((rope[I + 1] = moveTail(rope[I], rope[I + 1])), ...);
+    }(std::make_index_sequence<N - 1>{});
+}
+
+/**
+ * Calls fun(slot, knot) for each tracked knot, where slot is the position of knot in the list of tracked knots. Both
+ * arguments are passed as std::integral_constant
+ */
+template<std::size_t ...Tracked, typename F>
+constexpr void forEachTracked(F &&fun) {
+    [&fun]<std::size_t ...Slot>(std::index_sequence<Slot...>) {
+        (fun(std::integral_constant<std::size_t, Slot>{}, std::integral_constant<std::size_t, Tracked>{}), ...);
+    }(std::make_index_sequence<sizeof...(Tracked)>{});
+}
+
+/**
+ * Cells visited by a knot, stored as horizontal and vertical spans instead of single cells. Single cells are
+ * horizontal spans of length one
+ */
+class VisitedSpans {
+public:
+    void addPoint(const Pos &p) {
+        horizontal.push_back({p.y, p.x, p.x});
+    }
+
+    /**
+     * Adds the cells from + dir, from + 2 * dir, ..., from + steps * dir
+     */
+    void addRun(const Pos &from, const Pos &dir, long steps) {
+        if (steps <= 0) {
+            return;
+        }
+
+        const auto first = from + dir;
+        const auto last = from + dir * steps;
+        if (dir.y == 0) {
+            horizontal.push_back({from.y, std::min(first.x, last.x), std::max(first.x, last.x)});
+        } else {
+            vertical.push_back({from.x, std::min(first.y, last.y), std::max(first.y, last.y)});
+        }
+    }
+
+    /**
+     * Number of distinct cells covered by all spans. Spans are merged per line, cells covered by both a horizontal and
+     * a vertical span are counted with a sweep over x using a Fenwick tree over the rows of horizontal spans
+     */
+    [[nodiscard]] std::size_t count() const {
+        const auto h = merge(horizontal);
+        const auto v = merge(vertical);
+        std::size_t total = 0;
+        for (const auto &s : h) {
+            total += s.to - s.from + 1;
+        }
+
+        for (const auto &s : v) {
+            total += s.to - s.from + 1;
+        }
+
+        std::vector<long> rows;
+        rows.reserve(h.size());
+        for (const auto &s : h) {
+            rows.emplace_back(s.line);
+        }
+
+        std::ranges::sort(rows);
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        auto rank = [&rows](long y) { return std::ranges::lower_bound(rows, y) - rows.begin(); };
+        enum EventType { Remove, Add, Query };
+        struct Event {
+            long x;
+            EventType type;
+            const Span *span;
+        };
+
+        std::vector<Event> events;
+        events.reserve(2 * h.size() + v.size());
+        for (const auto &s : h) {
+            events.push_back({s.from, Add, &s});
+            events.push_back({s.to + 1, Remove, &s});
+        }
+
+        for (const auto &s : v) {
+            events.push_back({s.line, Query, &s});
+        }
+
+        std::ranges::sort(events, [](const auto &a, const auto &b) {
+            return std::tie(a.x, a.type) < std::tie(b.x, b.type);
+        });
+
+        std::vector<long> tree(rows.size() + 1, 0);
+        auto update = [&tree](std::size_t idx, long val) {
+            for (++idx; idx < tree.size(); idx += idx & -idx) {
+                tree[idx] += val;
+            }
+        };
+
+        auto prefix = [&tree](std::size_t end) {
+            long ret = 0;
+            for (; end > 0; end -= end & -end) {
+                ret += tree[end];
+            }
+
+            return ret;
+        };
+
+        for (const auto &e : events) {
+            switch (e.type) {
+                case Add:
+                    update(rank(e.span->line), 1);
+                    break;
+                case Remove:
+                    update(rank(e.span->line), -1);
+                    break;
+                case Query:
+                    total -= prefix(std::ranges::upper_bound(rows, e.span->to) - rows.begin()) - prefix(rank(e.span->from));
+                    break;
+            }
+        }
+
+        return total;
+    }
+
+private:
+    struct Span {
+        long line, from, to;
+    };
+
+    static auto merge(std::vector<Span> spans) -> std::vector<Span> {
+        std::ranges::sort(spans, [](const auto &a, const auto &b) {
+            return std::tie(a.line, a.from) < std::tie(b.line, b.from);
+        });
+
+        std::vector<Span> ret;
+        for (const auto &s : spans) {
+            if (not ret.empty() && ret.back().line == s.line && s.from <= ret.back().to + 1) {
+                ret.back().to = std::max(ret.back().to, s.to);
+            } else {
+                ret.emplace_back(s);
+            }
+        }
+
+        return ret;
+    }
+
+    std::vector<Span> horizontal, vertical;
+};
+
+/**
+ * Reference simulation, moves the whole rope one step at a time
+ * @tparam N rope length
+ * @tparam Tracked indices of the knots whose visited positions are counted
+ */
+template<std::size_t N, std::size_t ...Tracked> requires RopeConfig<N, Tracked...>
+auto simulate(const std::vector<Motion> &motions) -> VisitedCounts<Tracked...> {
+    Pos head, min, max;
+    for (auto [dir, steps] : motions) {
+        head = head + moveHead({}, dir) * steps;
+        min = {std::min(min.x, head.x), std::min(min.y, head.y)};
+        max = {std::max(max.x, head.x), std::max(max.y, head.y)};
+    }
+
+    // knots never leave the bounding box of the head's trajectory
+    std::array<util::PositionSet, sizeof...(Tracked)> positions;
+    for (auto &p : positions) {
+        p.setBounds(min.x, min.y, max.x, max.y);
+    }
+
+    std::array<Pos, N> rope;
+    forEachTracked<Tracked...>([&](auto slot, auto knot) { positions[slot].insert(rope[knot].x, rope[knot].y); });
+    for (auto [dir, steps] : motions) {
+        while (steps-- > 0) {
+            rope[0] = moveHead(rope[0], dir);
+            pullRope(rope);
+            forEachTracked<Tracked...>([&](auto slot, auto knot) {
+                positions[slot].insert(rope[knot].x, rope[knot].y);
+            });
+        }
+    }
+
+    VisitedCounts<Tracked...> ret;
+    std::ranges::transform(positions, ret.begin(), [](const auto &p) { return p.size(); });
+    return ret;
+}
+
+/**
+ * Number of head steps in direction dir until follower has to move, assuming lead moves one step in direction dir
+ * per head step
+ */
+constexpr long stepsUntilPulled(const Pos &lead, const Pos &follower, const Pos &dir) noexcept {
+    const auto rel = lead - follower;
+    return 2 - (rel.x * dir.x + rel.y * dir.y);
+}
+
+/**
+ * Simulation that advances straight runs in bulk. The knots directly trailing the head in a straight line move
+ * rigidly with it, the first knot that is not part of that line does not move until the line has come close enough
+ * to pull it. Everything in between is skipped, single steps are only simulated when the rope bends.
+ */
+template<std::size_t N, std::size_t ...Tracked> requires RopeConfig<N, Tracked...>
+auto simulateRunLength(const std::vector<Motion> &motions) -> VisitedCounts<Tracked...> {
+    std::array<Pos, N> rope;
+    std::array<VisitedSpans, sizeof...(Tracked)> visited;
+    forEachTracked<Tracked...>([&](auto slot, auto knot) { visited[slot].addPoint(rope[knot]); });
+    for (auto [dir, steps] : motions) {
+        const auto d = moveHead({}, dir);
+        long remaining = steps;
+        while (remaining > 0) {
+            std::size_t locked = 1;
+            while (locked < N && rope[locked] == rope[locked - 1] - d) {
+                ++locked;
+            }
+
+            long bulk = remaining;
+            if (locked < N) {
+                bulk = std::min(bulk, stepsUntilPulled(rope[locked - 1], rope[locked], d) - 1);
+            }
+
+            if (bulk > 0) {
+                forEachTracked<Tracked...>([&](auto slot, auto knot) {
+                    if (knot < locked) {
+                        visited[slot].addRun(rope[knot], d, bulk);
+                    }
+                });
+
+                for (std::size_t i = 0; i < locked; ++i) {
+                    rope[i] = rope[i] + d * bulk;
+                }
+
+                remaining -= bulk;
+                continue;
+            }
+
+            rope[0] = rope[0] + d;
+            pullRope(rope);
+            forEachTracked<Tracked...>([&](auto slot, auto knot) { visited[slot].addPoint(rope[knot]); });
+            --remaining;
+        }
+    }
+
+    VisitedCounts<Tracked...> ret;
+    std::ranges::transform(visited, ret.begin(), [](const auto &v) { return v.count(); });
+    return ret;
+}
+
+constexpr std::size_t MaxDispatchedRopeLength = 16;
+
+/**
+ * Runtime dispatch over the rope lengths 2 to MaxDispatchedRopeLength. Tracks every knot in a single simulation
+ * @return number of visited positions for each knot
+ */
+auto simulateAllKnots(std::size_t ropeLength, const std::vector<Motion> &motions) -> std::vector<std::size_t> {
+    std::vector<std::size_t> ret;
+    auto dispatch = [&]<std::size_t N>(std::integral_constant<std::size_t, N>) {
+        [&]<std::size_t ...Knot>(std::index_sequence<Knot...>) {
+            auto counts = simulateRunLength<N, Knot...>(motions);
+            ret.assign(counts.begin(), counts.end());
+        }(std::make_index_sequence<N>{});
+    };
+
+    bool found = [&]<std::size_t ...L>(std::index_sequence<L...>) {
+        return ((ropeLength == L + 2 && (dispatch(std::integral_constant<std::size_t, L + 2>{}), true)) || ...);
+    }(std::make_index_sequence<MaxDispatchedRopeLength - 1>{});
+    if (not found) {
+        throw std::invalid_argument("unsupported rope length " + std::to_string(ropeLength));
+    }
+
+    return ret;
+}
+
+/**
+ * usage: Day9 [input file] [rope length]. Without rope length, solves both parts. Otherwise, prints the number of
+ * visited positions of each knot of a rope of the given length
+ */
 int main(int argc, char **argv) {
-    auto file = util::getInputFile(argc, argv);
+    auto file = util::getInputFile(std::min(argc, 2), argv);
     std::string line;
-    std::array<Pos, 10> rope;
-    std::unordered_set<std::string> positionsShort;
-    std::unordered_set<std::string> positionsLong;
-    unsigned numVisitedShort = 0;
-    unsigned numVisitedLong = 0;
+    std::vector<Motion> motions;
     while (std::getline(file, line)) {
-        char dir;
-        unsigned steps;
+        Motion m;
         std::stringstream ss(line);
-        ss >> dir >> steps;
-        while (steps-- > 0) {
-            rope[0] = moveHead(rope[0], dir);
-            for (auto [tmpHead, tmpTail] : iterators::zip(rope, rope | std::views::drop(1))) {
-                tmpTail = moveTail(tmpHead, tmpTail);
-            }
+        ss >> m.dir >> m.steps;
+        motions.emplace_back(m);
+    }
 
-            auto [_, inserted] = positionsShort.emplace(rope[1].toString());
-            numVisitedShort += inserted;
-            std::tie(_, inserted) = positionsLong.emplace(rope.back().toString());
-            numVisitedLong += inserted;
+    if (argc > 2) {
+        try {
+            const auto counts = simulateAllKnots(std::strtoul(argv[2], nullptr, 10), motions);
+            for (std::size_t knot = 0; knot < counts.size(); ++knot) {
+                std::cout << "number of visited positions knot " << knot << " " << counts[knot] << std::endl;
+            }
+        } catch (const std::invalid_argument &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
         }
+
+        return 0;
     }
 
+    const auto counts = simulateRunLength<10, 1, 9>(motions);
+    assert((simulate<10, 1, 9>(motions) == counts));
+    auto [numVisitedShort, numVisitedLong] = counts;
     std::cout << "number of visited positions a1 " << numVisitedShort << std::endl;
     std::cout << "number of visited positions a2 " << numVisitedLong << std::endl;
 }
@@ -0,0 +1,282 @@
+#ifndef AOC22_GRID_HPP
+#define AOC22_GRID_HPP
+
+#include <vector>
+#include <array>
+#include <span>
+#include <ranges>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+namespace util {
+    /**
+     * Memory layout of a Grid.
+     * RowMajor: classic row after row storage
+     * Tiled: square tiles of Grid::TileSize cells, each stored row-major, tiles are stored row-major as well
+     * Morton: Z-order curve over the whole (square, power of two sized) storage
+     */
+    enum class Layout {
+        RowMajor, Tiled, Morton
+    };
+
+    struct GridPos {
+        using Coord = std::ptrdiff_t;
+
+        constexpr GridPos(Coord x, Coord y) noexcept: x(x), y(y) {}
+
+        constexpr GridPos() noexcept: GridPos(0, 0) {}
+
+        constexpr GridPos operator+(const GridPos &other) const noexcept {
+            return {x + other.x, y + other.y};
+        }
+
+        constexpr GridPos operator-(const GridPos &other) const noexcept {
+            return {x - other.x, y - other.y};
+        }
+
+        constexpr bool operator==(const GridPos &other) const noexcept = default;
+
+        Coord x, y;
+    };
+
+    /**
+     * Fixed capacity range holding the (at most four) direct neighbours of a grid cell
+     */
+    class Neighbours {
+    public:
+        constexpr void push(const GridPos &pos) noexcept {
+            items[count++] = pos;
+        }
+
+        [[nodiscard]] constexpr auto begin() const noexcept {
+            return items.begin();
+        }
+
+        [[nodiscard]] constexpr auto end() const noexcept {
+            return items.begin() + count;
+        }
+
+        [[nodiscard]] constexpr std::size_t size() const noexcept {
+            return count;
+        }
+
+    private:
+        std::array<GridPos, 4> items{};
+        std::size_t count = 0;
+    };
+
+    /**
+     * Two dimensional container of width x height cells with selectable memory layout. Optionally, the grid is
+     * surrounded by a border of padding cells. Border cells can be accessed with coordinates in [-padding, 0) and
+     * [width, width + padding) (same for y) without any bounds checks, which allows stencil-like access to direct
+     * neighbours if the border is filled with a suitable sentinel value.
+     * @tparam T cell type
+     * @tparam L memory layout
+     */
+    template<typename T, Layout L = Layout::RowMajor>
+    class Grid {
+    public:
+        using Coord = GridPos::Coord;
+        static constexpr std::size_t TileSize = 8;
+        static constexpr std::array<GridPos, 4> Directions{GridPos(-1, 0), GridPos(1, 0), GridPos(0, -1),
+                                                           GridPos(0, 1)};
+
+        Grid() = default;
+
+        Grid(std::size_t width, std::size_t height, const T &init = T{}, std::size_t padding = 0,
+             const T &border = T{}) : w(width), h(height), pad(padding), paddedW(width + 2 * padding),
+                                      paddedH(height + 2 * padding) {
+            if constexpr (L == Layout::RowMajor) {
+                cells.resize(paddedW * paddedH, border);
+            } else if constexpr (L == Layout::Tiled) {
+                tilesX = (paddedW + TileSize - 1) / TileSize;
+                cells.resize(tilesX * TileSize * ((paddedH + TileSize - 1) / TileSize) * TileSize, border);
+            } else {
+                auto side = std::bit_ceil(std::max(paddedW, paddedH));
+                cells.resize(side * side, border);
+            }
+
+            for (Coord y = 0; y < static_cast<Coord>(h); ++y) {
+                for (Coord x = 0; x < static_cast<Coord>(w); ++x) {
+                    (*this)(x, y) = init;
+                }
+            }
+        }
+
+        [[nodiscard]] constexpr std::size_t width() const noexcept {
+            return w;
+        }
+
+        [[nodiscard]] constexpr std::size_t height() const noexcept {
+            return h;
+        }
+
+        [[nodiscard]] constexpr std::size_t padding() const noexcept {
+            return pad;
+        }
+
+        /**
+         * @return number of stored cells including border and layout overhead. All indices returned by index() are
+         * smaller than this
+         */
+        [[nodiscard]] constexpr std::size_t storageSize() const noexcept {
+            return cells.size();
+        }
+
+        [[nodiscard]] constexpr T *data() noexcept {
+            return cells.data();
+        }
+
+        [[nodiscard]] constexpr const T *data() const noexcept {
+            return cells.data();
+        }
+
+        [[nodiscard]] constexpr bool contains(Coord x, Coord y) const noexcept {
+            return x >= 0 && y >= 0 && x < static_cast<Coord>(w) && y < static_cast<Coord>(h);
+        }
+
+        [[nodiscard]] constexpr bool contains(const GridPos &pos) const noexcept {
+            return contains(pos.x, pos.y);
+        }
+
+        /**
+         * Storage index of a cell. Valid for interior and border cells
+         */
+        [[nodiscard]] constexpr std::size_t index(Coord x, Coord y) const noexcept {
+            auto ux = static_cast<std::size_t>(x + static_cast<Coord>(pad));
+            auto uy = static_cast<std::size_t>(y + static_cast<Coord>(pad));
+            if constexpr (L == Layout::RowMajor) {
+                return uy * paddedW + ux;
+            } else if constexpr (L == Layout::Tiled) {
+                return ((uy / TileSize) * tilesX + ux / TileSize) * TileSize * TileSize +
+                       (uy % TileSize) * TileSize + ux % TileSize;
+            } else {
+                return spreadBits(ux) | (spreadBits(uy) << 1);
+            }
+        }
+
+        [[nodiscard]] constexpr std::size_t index(const GridPos &pos) const noexcept {
+            return index(pos.x, pos.y);
+        }
+
+        /**
+         * Inverse of index()
+         */
+        [[nodiscard]] constexpr GridPos position(std::size_t idx) const noexcept {
+            std::size_t ux, uy;
+            if constexpr (L == Layout::RowMajor) {
+                ux = idx % paddedW;
+                uy = idx / paddedW;
+            } else if constexpr (L == Layout::Tiled) {
+                auto tile = idx / (TileSize * TileSize);
+                auto inner = idx % (TileSize * TileSize);
+                ux = (tile % tilesX) * TileSize + inner % TileSize;
+                uy = (tile / tilesX) * TileSize + inner / TileSize;
+            } else {
+                ux = compactBits(idx);
+                uy = compactBits(idx >> 1);
+            }
+
+            return {static_cast<Coord>(ux) - static_cast<Coord>(pad), static_cast<Coord>(uy) - static_cast<Coord>(pad)};
+        }
+
+        constexpr T &operator()(Coord x, Coord y) noexcept {
+            return cells[index(x, y)];
+        }
+
+        constexpr const T &operator()(Coord x, Coord y) const noexcept {
+            return cells[index(x, y)];
+        }
+
+        constexpr T &operator()(const GridPos &pos) noexcept {
+            return (*this)(pos.x, pos.y);
+        }
+
+        constexpr const T &operator()(const GridPos &pos) const noexcept {
+            return (*this)(pos.x, pos.y);
+        }
+
+        constexpr T &operator[](std::size_t idx) noexcept {
+            return cells[idx];
+        }
+
+        constexpr const T &operator[](std::size_t idx) const noexcept {
+            return cells[idx];
+        }
+
+        /**
+         * @return all direct neighbours of pos that lie inside the grid (left, right, up, down)
+         */
+        [[nodiscard]] constexpr Neighbours neighbours(const GridPos &pos) const noexcept {
+            Neighbours ret;
+            for (const auto &dir: Directions) {
+                if (contains(pos + dir)) {
+                    ret.push(pos + dir);
+                }
+            }
+
+            return ret;
+        }
+
+        /**
+         * View of row y. Contiguous (std::span) for row-major grids
+         */
+        [[nodiscard]] auto row(Coord y) noexcept {
+            if constexpr (L == Layout::RowMajor) {
+                return std::span<T>(cells.data() + index(0, y), w);
+            } else {
+                return std::views::iota(Coord(0), static_cast<Coord>(w)) |
+                       std::views::transform([this, y](Coord x) -> T & { return (*this)(x, y); });
+            }
+        }
+
+        [[nodiscard]] auto row(Coord y) const noexcept {
+            if constexpr (L == Layout::RowMajor) {
+                return std::span<const T>(cells.data() + index(0, y), w);
+            } else {
+                return std::views::iota(Coord(0), static_cast<Coord>(w)) |
+                       std::views::transform([this, y](Coord x) -> const T & { return (*this)(x, y); });
+            }
+        }
+
+        [[nodiscard]] auto column(Coord x) noexcept {
+            return std::views::iota(Coord(0), static_cast<Coord>(h)) |
+                   std::views::transform([this, x](Coord y) -> T & { return (*this)(x, y); });
+        }
+
+        [[nodiscard]] auto column(Coord x) const noexcept {
+            return std::views::iota(Coord(0), static_cast<Coord>(h)) |
+                   std::views::transform([this, x](Coord y) -> const T & { return (*this)(x, y); });
+        }
+
+    private:
+        static constexpr std::size_t spreadBits(std::uint64_t v) noexcept {
+            v &= 0xFFFFFFFF;
+            v = (v | (v << 16)) & 0x0000FFFF0000FFFF;
+            v = (v | (v << 8)) & 0x00FF00FF00FF00FF;
+            v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0F;
+            v = (v | (v << 2)) & 0x3333333333333333;
+            v = (v | (v << 1)) & 0x5555555555555555;
+            return v;
+        }
+
+        static constexpr std::size_t compactBits(std::uint64_t v) noexcept {
+            v &= 0x5555555555555555;
+            v = (v | (v >> 1)) & 0x3333333333333333;
+            v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0F;
+            v = (v | (v >> 4)) & 0x00FF00FF00FF00FF;
+            v = (v | (v >> 8)) & 0x0000FFFF0000FFFF;
+            v = (v | (v >> 16)) & 0x00000000FFFFFFFF;
+            return v;
+        }
+
+        std::size_t w = 0, h = 0, pad = 0;
+        std::size_t paddedW = 0, paddedH = 0;
+        std::size_t tilesX = 0;
+        std::vector<T> cells;
+    };
+}
+
+#endif //AOC22_GRID_HPP
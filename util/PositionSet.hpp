@@ -0,0 +1,259 @@
+#ifndef AOC22_POSITIONSET_HPP
+#define AOC22_POSITIONSET_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <bit>
+#include <optional>
+
+namespace util {
+    namespace impl {
+        constexpr std::uint64_t packCoordinates(int x, int y) noexcept {
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+        }
+
+        constexpr int unpackX(std::uint64_t key) noexcept {
+            return static_cast<int>(static_cast<std::uint32_t>(key >> 32));
+        }
+
+        constexpr int unpackY(std::uint64_t key) noexcept {
+            return static_cast<int>(static_cast<std::uint32_t>(key));
+        }
+
+        /**
+         * Open addressing hash set (linear probing) of 64 bit keys. One key value is reserved as empty marker and
+         * tracked separately
+         */
+        class FlatKeySet {
+            static constexpr std::uint64_t Empty = std::numeric_limits<std::uint64_t>::max();
+        public:
+            explicit FlatKeySet(std::size_t capacity = 64) : slots(std::bit_ceil(std::max<std::size_t>(capacity, 16)),
+                                                                   Empty), shift(shiftFor(slots.size())) {}
+
+            bool insert(std::uint64_t key) {
+                if (key == Empty) {
+                    bool inserted = not containsEmptyKey;
+                    containsEmptyKey = true;
+                    return inserted;
+                }
+
+                if (2 * (numElements + 1) > slots.size()) {
+                    rehash(2 * slots.size());
+                }
+
+                for (auto idx = bucket(key);; idx = (idx + 1) & (slots.size() - 1)) {
+                    if (slots[idx] == key) {
+                        return false;
+                    }
+
+                    if (slots[idx] == Empty) {
+                        slots[idx] = key;
+                        ++numElements;
+                        return true;
+                    }
+                }
+            }
+
+            [[nodiscard]] std::size_t size() const noexcept {
+                return numElements + containsEmptyKey;
+            }
+
+            template<typename F>
+            void forEach(F &&fun) const {
+                for (auto key: slots) {
+                    if (key != Empty) {
+                        fun(key);
+                    }
+                }
+
+                if (containsEmptyKey) {
+                    fun(Empty);
+                }
+            }
+
+        private:
+            static constexpr unsigned shiftFor(std::size_t capacity) noexcept {
+                return 64 - std::countr_zero(capacity);
+            }
+
+            [[nodiscard]] std::size_t bucket(std::uint64_t key) const noexcept {
+                return (key * 0x9E3779B97F4A7C15ull) >> shift;
+            }
+
+            void rehash(std::size_t capacity) {
+                std::vector<std::uint64_t> old(capacity, Empty);
+                std::swap(old, slots);
+                shift = shiftFor(slots.size());
+                for (auto key: old) {
+                    if (key == Empty) {
+                        continue;
+                    }
+
+                    auto idx = bucket(key);
+                    while (slots[idx] != Empty) {
+                        idx = (idx + 1) & (slots.size() - 1);
+                    }
+
+                    slots[idx] = key;
+                }
+            }
+
+            std::vector<std::uint64_t> slots;
+            unsigned shift;
+            std::size_t numElements = 0;
+            bool containsEmptyKey = false;
+        };
+
+        /**
+         * One bit per cell over an axis aligned bounding box. Grows (doubling the extent in the required direction)
+         * when a position outside the box is inserted
+         */
+        class BitmapGrid {
+        public:
+            BitmapGrid(long minX, long minY, long maxX, long maxY) : minX(minX), minY(minY),
+                                                                     width(maxX - minX + 1), height(maxY - minY + 1),
+                                                                     bits(wordsFor(width, height), 0) {}
+
+            bool insert(int x, int y) {
+                if (x < minX || y < minY || x >= minX + width || y >= minY + height) {
+                    grow(x, y);
+                }
+
+                auto idx = static_cast<std::size_t>((y - minY) * width + (x - minX));
+                auto mask = std::uint64_t(1) << (idx % 64);
+                auto &word = bits[idx / 64];
+                bool inserted = (word & mask) == 0;
+                word |= mask;
+                numElements += inserted;
+                return inserted;
+            }
+
+            [[nodiscard]] std::size_t size() const noexcept {
+                return numElements;
+            }
+
+        private:
+            static std::size_t wordsFor(long w, long h) noexcept {
+                return static_cast<std::size_t>(w * h + 63) / 64;
+            }
+
+            void grow(int x, int y) {
+                auto newMinX = minX, newMinY = minY, newW = width, newH = height;
+                while (x < newMinX || x >= newMinX + newW) {
+                    if (x < newMinX) {
+                        newMinX -= newW;
+                    }
+
+                    newW *= 2;
+                }
+
+                while (y < newMinY || y >= newMinY + newH) {
+                    if (y < newMinY) {
+                        newMinY -= newH;
+                    }
+
+                    newH *= 2;
+                }
+
+                BitmapGrid grown(newMinX, newMinY, newMinX + newW - 1, newMinY + newH - 1);
+                for (long row = 0; row < height; ++row) {
+                    for (long col = 0; col < width; ++col) {
+                        auto idx = static_cast<std::size_t>(row * width + col);
+                        if (bits[idx / 64] & (std::uint64_t(1) << (idx % 64))) {
+                            grown.insert(static_cast<int>(minX + col), static_cast<int>(minY + row));
+                        }
+                    }
+                }
+
+                *this = std::move(grown);
+            }
+
+            long minX, minY, width, height;
+            std::vector<std::uint64_t> bits;
+            std::size_t numElements = 0;
+        };
+    }
+
+    /**
+     * Set of 2D integer positions. Positions are packed into 64 bit keys and stored in a flat hash set. As soon as the
+     * bounding box of the stored positions is known (setBounds) and small enough, or the positions are dense enough,
+     * the set switches to a growable bitmap with one bit per cell.
+     */
+    class PositionSet {
+        static constexpr std::size_t DenseCheckThreshold = 4096;
+        static constexpr long MaxBitsPerElement = 64;
+        // largest bitmap (in bits) that setBounds allocates up front, before any position is known
+        static constexpr long MaxBoundsArea = long(1) << 26;
+    public:
+        PositionSet() = default;
+
+        PositionSet(int minX, int minY, int maxX, int maxY) {
+            setBounds(minX, minY, maxX, maxY);
+        }
+
+        /**
+         * Switches to bitmap storage covering the given box (inclusive) if it has at most MaxBoundsArea cells,
+         * otherwise the positions stay in the hash set. Positions outside of the box are still supported
+         */
+        void setBounds(int minX, int minY, int maxX, int maxY) {
+            if (dense.has_value()) {
+                return;
+            }
+
+            bbMinX = std::min(bbMinX, minX);
+            bbMinY = std::min(bbMinY, minY);
+            bbMaxX = std::max(bbMaxX, maxX);
+            bbMaxY = std::max(bbMaxY, maxY);
+            if (area() > std::max(MaxBoundsArea, MaxBitsPerElement * static_cast<long>(sparse.size()))) {
+                return;
+            }
+
+            dense.emplace(bbMinX, bbMinY, bbMaxX, bbMaxY);
+            sparse.forEach([this](auto key) { dense->insert(impl::unpackX(key), impl::unpackY(key)); });
+            sparse = impl::FlatKeySet{};
+        }
+
+        /**
+         * @return true if the position was not contained before
+         */
+        bool insert(int x, int y) {
+            if (dense.has_value()) {
+                return dense->insert(x, y);
+            }
+
+            bbMinX = std::min(bbMinX, x);
+            bbMinY = std::min(bbMinY, y);
+            bbMaxX = std::max(bbMaxX, x);
+            bbMaxY = std::max(bbMaxY, y);
+            bool inserted = sparse.insert(impl::packCoordinates(x, y));
+            if (inserted && sparse.size() % DenseCheckThreshold == 0 && denseEnough()) {
+                setBounds(bbMinX, bbMinY, bbMaxX, bbMaxY);
+            }
+
+            return inserted;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return dense.has_value() ? dense->size() : sparse.size();
+        }
+
+    private:
+        [[nodiscard]] long area() const noexcept {
+            return (static_cast<long>(bbMaxX) - bbMinX + 1) * (static_cast<long>(bbMaxY) - bbMinY + 1);
+        }
+
+        [[nodiscard]] bool denseEnough() const noexcept {
+            return area() <= MaxBitsPerElement * static_cast<long>(sparse.size());
+        }
+
+        impl::FlatKeySet sparse;
+        std::optional<impl::BitmapGrid> dense;
+        int bbMinX = std::numeric_limits<int>::max(), bbMinY = std::numeric_limits<int>::max();
+        int bbMaxX = std::numeric_limits<int>::min(), bbMaxY = std::numeric_limits<int>::min();
+    };
+}
+
+#endif //AOC22_POSITIONSET_HPP